@@ -0,0 +1,197 @@
+#include "GeometryBatcher.h"
+
+#include <cstring>
+
+namespace
+{
+	const std::uint64_t s_maxVertices16 = 0x10000;
+
+	// Narrows indices that are known to fit into 16 bits.  A plain loop, so the compiler
+	// can turn it into packs.
+	void CopyIndices16(const uint32* src, size_t count, std::uint16_t* dest)
+	{
+		for (size_t i = 0; i < count; ++i)
+			dest[i] = static_cast<std::uint16_t>(src[i]);
+	}
+}
+
+uint32 GeometryBatcher::Add(const std::string& name, const GeometryGenerator::MeshData& meshData,
+	const DirectX::XMFLOAT4& color)
+{
+	Entry entry;
+	entry.m_name = name;
+	entry.m_meshData = &meshData;
+	entry.m_color = color;
+	entry.m_vertexSource = (uint32)m_entries.size();
+
+	m_entries.push_back(entry);
+
+	return entry.m_vertexSource;
+}
+
+void GeometryBatcher::AddIndices(const std::string& name, uint32 vertexSource, const GeometryGenerator::MeshData& meshData)
+{
+	assert(vertexSource < m_entries.size() && m_entries[vertexSource].m_vertexSource == vertexSource);
+
+	Entry entry;
+	entry.m_name = name;
+	entry.m_meshData = &meshData;
+	entry.m_vertexSource = vertexSource;
+
+	m_entries.push_back(entry);
+}
+
+void GeometryBatcher::Build(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList,
+	const GeometryGenerator::VertexLayout& layout, MeshGeometry& geo) const
+{
+	GeometryGenerator geoGen;
+
+	//
+	// Split the meshes that 16-bit indices cannot address.  An entry drawn against the
+	// vertices of such a mesh is split as well, into its own copies of the vertices it
+	// uses, since splitting the source duplicates and reorders its vertices.  If any split
+	// would cost more than it saves, nothing is split and the index buffer is 32-bit.
+	//
+
+	std::vector<const GeometryGenerator::MeshData*> meshes(m_entries.size());
+	std::vector<std::vector<GeometryGenerator::IndexPartition>> partitions(m_entries.size());
+	std::vector<GeometryGenerator::MeshData> splitMeshes(m_entries.size());
+	bool indices16 = true;
+
+	for (size_t i = 0; i < m_entries.size(); ++i)
+	{
+		const Entry& entry = m_entries[i];
+		const GeometryGenerator::MeshData& source = *m_entries[entry.m_vertexSource].m_meshData;
+
+		meshes[i] = entry.m_meshData;
+
+		if (!indices16 || source.m_vertices.size() <= s_maxVertices16)
+			continue;
+
+		GeometryGenerator::MeshData& split = splitMeshes[i];
+		split.m_vertices.assign(source.m_vertices.begin(), source.m_vertices.end());
+		split.m_indices32.assign(entry.m_meshData->m_indices32.begin(), entry.m_meshData->m_indices32.end());
+		split.m_boundingBox = entry.m_meshData->m_boundingBox;
+		split.m_boundingSphere = entry.m_meshData->m_boundingSphere;
+
+		indices16 = geoGen.PartitionIndices16(split, partitions[i], layout.m_stride);
+		meshes[i] = &split;
+	}
+
+	if (!indices16)
+	{
+		for (size_t i = 0; i < m_entries.size(); ++i)
+		{
+			meshes[i] = m_entries[i].m_meshData;
+			partitions[i].clear();
+		}
+
+		splitMeshes.clear();
+	}
+
+	//
+	// Lay out every entry before copying anything.  A split entry has its own vertices,
+	// and its partitions are drawn from consecutive ranges of its indices.
+	//
+
+	std::vector<SubmeshGeometry> submeshes(m_entries.size());
+
+	std::uint64_t vertexCount = 0;
+	std::uint64_t indexCount = 0;
+
+	for (size_t i = 0; i < m_entries.size(); ++i)
+	{
+		const Entry& entry = m_entries[i];
+		const GeometryGenerator::MeshData& meshData = *meshes[i];
+
+		if (entry.m_vertexSource == i || !partitions[i].empty())
+		{
+			submeshes[i].BaseVertexLocation = (INT)vertexCount;
+			vertexCount += meshData.m_vertices.size();
+		}
+		else
+		{
+			submeshes[i].BaseVertexLocation = submeshes[entry.m_vertexSource].BaseVertexLocation;
+		}
+
+		submeshes[i].IndexCount = (UINT)meshData.m_indices32.size();
+		submeshes[i].StartIndexLocation = (UINT)indexCount;
+		submeshes[i].Bounds = meshData.m_boundingBox;
+		submeshes[i].SphereBounds = meshData.m_boundingSphere;
+
+		indexCount += meshData.m_indices32.size();
+	}
+
+	const UINT indexByteStride = indices16 ? sizeof(std::uint16_t) : sizeof(uint32);
+	const UINT vbByteSize = (UINT)(vertexCount * layout.m_stride);
+	const UINT ibByteSize = (UINT)(indexCount * indexByteStride);
+
+	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo.VertexBufferCPU));
+	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo.IndexBufferCPU));
+
+	std::uint8_t* vertices = static_cast<std::uint8_t*>(geo.VertexBufferCPU->GetBufferPointer());
+	std::uint8_t* indices = static_cast<std::uint8_t*>(geo.IndexBufferCPU->GetBufferPointer());
+
+	//
+	// Fill both buffers front to back.
+	//
+
+	GeometryGenerator::VertexLayout entryLayout = layout;
+
+	for (size_t i = 0; i < m_entries.size(); ++i)
+	{
+		const Entry& entry = m_entries[i];
+		const GeometryGenerator::MeshData& meshData = *meshes[i];
+		const SubmeshGeometry& submesh = submeshes[i];
+
+		if (entry.m_vertexSource == i || !partitions[i].empty())
+		{
+			entryLayout.m_color = m_entries[entry.m_vertexSource].m_color;
+			geoGen.WriteVertices(meshData, entryLayout,
+				vertices + (std::uint64_t)submesh.BaseVertexLocation * layout.m_stride);
+		}
+
+		std::uint8_t* dest = indices + (std::uint64_t)submesh.StartIndexLocation * indexByteStride;
+		if (indices16)
+			CopyIndices16(meshData.m_indices32.data(), meshData.m_indices32.size(), reinterpret_cast<std::uint16_t*>(dest));
+		else
+			std::memcpy(dest, meshData.m_indices32.data(), meshData.m_indices32.size() * sizeof(uint32));
+
+		if (partitions[i].empty())
+		{
+			geo.DrawArgs[entry.m_name] = submesh;
+			continue;
+		}
+
+		// The bounds are those of the whole mesh, which hold for each part too.
+		for (size_t p = 0; p < partitions[i].size(); ++p)
+		{
+			const GeometryGenerator::IndexPartition& partition = partitions[i][p];
+
+			SubmeshGeometry part = submesh;
+			part.IndexCount = partition.m_indexCount;
+			part.StartIndexLocation = submesh.StartIndexLocation + partition.m_startIndexLocation;
+			part.BaseVertexLocation = submesh.BaseVertexLocation + partition.m_baseVertexLocation;
+
+			geo.DrawArgs[GetPartName(entry.m_name, (uint32)p)] = part;
+		}
+	}
+
+	geo.VertexBufferGPU = d3dUtil::CreateDefaultBuffer(device, cmdList, vertices, vbByteSize, geo.VertexBufferUploader);
+	geo.IndexBufferGPU = d3dUtil::CreateDefaultBuffer(device, cmdList, indices, ibByteSize, geo.IndexBufferUploader);
+
+	geo.VertexByteStride = layout.m_stride;
+	geo.VertexBufferByteSize = vbByteSize;
+	geo.IndexFormat = indices16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	geo.IndexBufferByteSize = ibByteSize;
+}
+
+std::string GeometryBatcher::GetPartName(const std::string& name, uint32 part)
+{
+	return name + "#" + std::to_string(part);
+}
+
+void GeometryBatcher::Clear()
+{
+	m_entries.clear();
+}
@@ -0,0 +1,57 @@
+//***************************************************************************************
+// GeometryBatcher.h
+//
+// Packs any number of GeometryGenerator meshes into the one vertex buffer and one index
+// buffer of a MeshGeometry, with a DrawArgs entry per mesh.  All offsets are worked out
+// before anything is copied, so each buffer is allocated once at its final size.
+//***************************************************************************************
+#pragma once
+
+#include "d3dUtil.h"
+#include "GeometryGenerator.h"
+
+class GeometryBatcher
+{
+public:
+	// Changes whenever Build lays out the same meshes differently.  Hash it into cache
+	// keys along with GeometryGenerator::s_outputVersion, and bump it with the change.
+	static constexpr uint32 s_outputVersion = 1;
+
+	// Adds a mesh drawn as DrawArgs[name].  Its vertices are written with the layout
+	// passed to Build, using color for the layout's colour slot.  The mesh is referenced,
+	// not copied, so it must stay alive until Build.  Returns a handle for AddIndices.
+	uint32 Add(const std::string& name, const GeometryGenerator::MeshData& meshData,
+		const DirectX::XMFLOAT4& color = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+
+	// Adds the triangles of meshData, drawn as DrawArgs[name], against the vertices of the
+	// mesh added as vertexSource instead of its own.  Used for the levels of a
+	// BuildLodChain, which index a prefix of the full-detail vertices.
+	void AddIndices(const std::string& name, uint32 vertexSource, const GeometryGenerator::MeshData& meshData);
+
+	// Fills in the CPU copies, default heap buffers (recorded on cmdList) and DrawArgs of
+	// geo.  The index buffer is 16-bit.  A mesh with more than 65536 vertices, or drawn
+	// against one, is split by GeometryGenerator::PartitionIndices16 into parts drawn as
+	// DrawArgs[GetPartName(name, 0)], DrawArgs[GetPartName(name, 1)] and so on, each with
+	// its own base vertex, instead of DrawArgs[name].  The index buffer is 32-bit, with
+	// nothing split, only if some split would cost more vertex memory than it saves.
+	void Build(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList,
+		const GeometryGenerator::VertexLayout& layout, MeshGeometry& geo) const;
+
+	// The DrawArgs key of part of a mesh that Build split.
+	static std::string GetPartName(const std::string& name, uint32 part);
+
+	void Clear();
+
+private:
+	struct Entry
+	{
+		std::string m_name;
+		const GeometryGenerator::MeshData* m_meshData = nullptr;
+		DirectX::XMFLOAT4 m_color = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+
+		// The entry whose vertices this one indexes; its own index if it has vertices.
+		uint32 m_vertexSource = 0;
+	};
+
+	std::vector<Entry> m_entries;
+};
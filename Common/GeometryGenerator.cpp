@@ -1,357 +1,2815 @@
 ﻿#include "GeometryGenerator.h"
 
-GeometryGenerator::Vertex::Vertex()
-	: m_position(0, 0, 0),
-	m_normal(0, 0, 0),
-	m_tangentU(0, 0, 0),
-	m_texC(0, 0)
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace
 {
+	// Below this many vertices per task the cost of starting a thread outweighs
+	// the work it would do.
+	const uint32 s_minVerticesPerTask = 16 * 1024;
+
+	// Splits [0, count) into contiguous chunks of at least minChunk items and runs
+	// body(begin, end) for each chunk on its own thread.  The calling thread takes
+	// the first chunk, and small workloads run entirely inline.
+	template<typename Body>
+	void ParallelFor(uint32 count, uint32 minChunk, const Body& body)
+	{
+		if (count == 0)
+			return;
+
+		minChunk = std::max(minChunk, 1u);
+		uint32 workers = std::max(std::thread::hardware_concurrency(), 1u);
+		workers = std::min(workers, (count + minChunk - 1) / minChunk);
+
+		if (workers <= 1)
+		{
+			body(0u, count);
+			return;
+		}
+
+		uint32 chunk = (count + workers - 1) / workers;
+
+		std::vector<std::thread> threads;
+		threads.reserve(workers - 1);
+		for (uint32 begin = chunk; begin < count; begin += chunk)
+			threads.emplace_back([&body, begin, end = std::min(begin + chunk, count)]() { body(begin, end); });
+
+		body(0u, chunk);
+
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	// Vertex placement shared by CreateGrid and CreateGridTiles: an mxn grid in the
+	// xz-plane centered at the origin with the texture stretched over it.
+	struct GridLayout
+	{
+		GridLayout(float width, float depth, uint32 m, uint32 n)
+			: m_halfWidth(0.5f * width),
+			m_halfDepth(0.5f * depth),
+			m_dx(width / (n - 1)),
+			m_dz(depth / (m - 1)),
+			m_du(1.0f / (n - 1)),
+			m_dv(1.0f / (m - 1))
+		{
+		}
+
+		GeometryGenerator::Vertex At(uint32 i, uint32 j) const
+		{
+			float x = -m_halfWidth + j * m_dx;
+			float z = m_halfDepth - i * m_dz;
+
+			return GeometryGenerator::Vertex(x, 0.0f, z, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, j * m_du, i * m_dv);
+		}
+
+		float m_halfWidth;
+		float m_halfDepth;
+		float m_dx;
+		float m_dz;
+		float m_du;
+		float m_dv;
+	};
+
+	// Split of an mxn grid into tiles of at most tileQuads x tileQuads quads, in row-major
+	// tile order.  The last row and column of tiles take whatever is left over.  Border
+	// vertices are duplicated in the neighbouring tile so that each tile can be uploaded
+	// and drawn on its own.
+	struct GridTiling
+	{
+		GridTiling(uint32 m, uint32 n, uint32 tileQuads)
+			: m_m(m),
+			m_n(n),
+			m_tileQuads(std::max(tileQuads, 1u)),
+			m_tileRows((m - 2) / m_tileQuads + 1),
+			m_tileCols((n - 2) / m_tileQuads + 1)
+		{
+		}
+
+		uint32 TileCount() const { return m_tileRows * m_tileCols; }
+
+		// First grid vertex row and column of tile t and its size in vertices.
+		void Range(uint32 t, uint32& i0, uint32& j0, uint32& tileM, uint32& tileN) const
+		{
+			i0 = (t / m_tileCols) * m_tileQuads;
+			j0 = (t % m_tileCols) * m_tileQuads;
+			tileM = std::min(i0 + m_tileQuads, m_m - 1) - i0 + 1;
+			tileN = std::min(j0 + m_tileQuads, m_n - 1) - j0 + 1;
+		}
+
+		uint32 m_m;
+		uint32 m_n;
+		uint32 m_tileQuads;
+		uint32 m_tileRows;
+		uint32 m_tileCols;
+	};
+
+	// Visits the cells of a rows x cols grid along a Z-order curve, calling visit(i, j)
+	// with the row and column of each.  The curve covers the enclosing power of two
+	// square, and blocks of it that lie outside the grid are skipped whole.
+	template<typename Visit>
+	void VisitMorton(uint32 rows, uint32 cols, uint32 i0, uint32 j0, uint32 size, const Visit& visit)
+	{
+		if (i0 >= rows || j0 >= cols)
+			return;
+
+		if (size == 1)
+		{
+			visit(i0, j0);
+			return;
+		}
+
+		uint32 half = size / 2;
+		VisitMorton(rows, cols, i0, j0, half, visit);
+		VisitMorton(rows, cols, i0, j0 + half, half, visit);
+		VisitMorton(rows, cols, i0 + half, j0, half, visit);
+		VisitMorton(rows, cols, i0 + half, j0 + half, half, visit);
+	}
+
+	// Visits the cells of a rows x cols grid along a Hilbert curve.  The block being
+	// visited has a corner at (i0, j0) and is spanned from it by the vectors a and b,
+	// each size cells long.  Blocks outside the grid are skipped whole, as in VisitMorton.
+	template<typename Visit>
+	void VisitHilbert(std::int32_t rows, std::int32_t cols, std::int32_t i0, std::int32_t j0,
+		std::int32_t ai, std::int32_t aj, std::int32_t bi, std::int32_t bj, std::int32_t size, const Visit& visit)
+	{
+		std::int32_t iMin = i0 + std::min(ai, 0) + std::min(bi, 0);
+		std::int32_t jMin = j0 + std::min(aj, 0) + std::min(bj, 0);
+		if (iMin >= rows || jMin >= cols || iMin + size <= 0 || jMin + size <= 0)
+			return;
+
+		if (size == 1)
+		{
+			visit((uint32)iMin, (uint32)jMin);
+			return;
+		}
+
+		std::int32_t half = size / 2;
+		std::int32_t ahi = ai / 2, ahj = aj / 2;
+		std::int32_t bhi = bi / 2, bhj = bj / 2;
+
+		VisitHilbert(rows, cols, i0, j0, bhi, bhj, ahi, ahj, half, visit);
+		VisitHilbert(rows, cols, i0 + ahi, j0 + ahj, ahi, ahj, bhi, bhj, half, visit);
+		VisitHilbert(rows, cols, i0 + bhi + ahi, j0 + bhj + ahj, ahi, ahj, bhi, bhj, half, visit);
+		VisitHilbert(rows, cols, i0 + ahi + bi, j0 + ahj + bj, -bhi, -bhj, -ahi, -ahj, half, visit);
+	}
+
+	// Visits the quads of an mxn vertex grid in the given order, calling visit(i, j)
+	// with the row and column of each quad's first vertex.
+	template<typename Visit>
+	void VisitGridQuads(uint32 m, uint32 n, GeometryGenerator::GridOrder order, const Visit& visit)
+	{
+		uint32 rows = m - 1;
+		uint32 cols = n - 1;
+
+		uint32 size = 1;
+		while (size < std::max(rows, cols))
+			size <<= 1;
+
+		switch (order)
+		{
+		case GeometryGenerator::GridOrder::Morton:
+			VisitMorton(rows, cols, 0, 0, size, visit);
+			break;
+
+		case GeometryGenerator::GridOrder::Hilbert:
+			VisitHilbert((std::int32_t)rows, (std::int32_t)cols, 0, 0, 0, (std::int32_t)size, (std::int32_t)size, 0,
+				(std::int32_t)size, visit);
+			break;
+
+		default:
+			for (uint32 i = 0; i < rows; ++i)
+			{
+				for (uint32 j = 0; j < cols; ++j)
+					visit(i, j);
+			}
+			break;
+		}
+	}
+
+	// Writes the indices of an mxn vertex grid with its quads in the given order, and
+	// numbers the vertices in the order the quads first use them.  gridVertex receives
+	// the grid vertex (i * n + j) behind each output vertex; the scratch space comes from
+	// its memory resource.
+	void BuildOrderedGridIndices(uint32 m, uint32 n, GeometryGenerator::GridOrder order,
+		uint32* indices, std::pmr::vector<uint32>& gridVertex)
+	{
+		const uint32 unassigned = 0xffffffff;
+		std::pmr::vector<uint32> remap(m * n, unassigned, gridVertex.get_allocator());
+
+		gridVertex.clear();
+		gridVertex.reserve(m * n);
+
+		auto vertexIndex = [&](uint32 v)
+		{
+			if (remap[v] == unassigned)
+			{
+				remap[v] = (uint32)gridVertex.size();
+				gridVertex.push_back(v);
+			}
+
+			return remap[v];
+		};
+
+		uint32 k = 0;
+		VisitGridQuads(m, n, order, [&](uint32 i, uint32 j)
+		{
+			uint32 v00 = vertexIndex(i * n + j);
+			uint32 v01 = vertexIndex(i * n + j + 1);
+			uint32 v10 = vertexIndex((i + 1) * n + j);
+			uint32 v11 = vertexIndex((i + 1) * n + j + 1);
+
+			indices[k] = v00;
+			indices[k + 1] = v01;
+			indices[k + 2] = v10;
+
+			indices[k + 3] = v10;
+			indices[k + 4] = v01;
+			indices[k + 5] = v11;
+
+			k += 6;
+		});
+	}
+
+	const uint32 s_maxGeosphereSubdivisions = 6;
+
+	// Unit geosphere of one subdivision level.  The arrays point either into m_storage
+	// or into a blob handed to LoadGeosphereTopology.
+	struct GeosphereTopology
+	{
+		GeometryGenerator::MeshData m_storage{ std::pmr::new_delete_resource() };
+
+		const GeometryGenerator::Vertex* m_vertices = nullptr;
+		const uint32* m_indices = nullptr;
+		uint32 m_vertexCount = 0;
+		uint32 m_indexCount = 0;
+	};
+
+	// Levels are only ever added, never replaced, so a reference handed out under the
+	// lock stays valid without it.
+	struct GeosphereCache
+	{
+		std::mutex m_mutex;
+		std::unique_ptr<GeosphereTopology> m_levels[s_maxGeosphereSubdivisions + 1];
+	};
+
+	GeosphereCache& GetGeosphereCache()
+	{
+		static GeosphereCache cache;
+		return cache;
+	}
+
+	// Layout of a serialized geosphere: this header, then m_vertexCount vertices, then
+	// m_indexCount 32-bit indices.
+	struct GeosphereBlobHeader
+	{
+		uint32 m_magic;
+		uint32 m_version;
+		uint32 m_numSubdivisions;
+		uint32 m_vertexCount;
+		uint32 m_indexCount;
+	};
+
+	const uint32 s_geosphereBlobMagic = 0x4f454753; // "SGEO"
+	const uint32 s_geosphereBlobVersion = 1;
+
+	// Each subdivision splits every triangle in four and adds a vertex per edge.
+	uint32 GeosphereVertexCount(uint32 numSubdivisions) { return 10 * (1u << (2 * numSubdivisions)) + 2; }
+	uint32 GeosphereIndexCount(uint32 numSubdivisions) { return 60 * (1u << (2 * numSubdivisions)); }
+
+	// Returns the cached unit geosphere of the given level, calling build() to make it
+	// the first time it is asked for.
+	template<typename Build>
+	const GeosphereTopology& FindGeosphereTopology(uint32 numSubdivisions, const Build& build)
+	{
+		GeosphereCache& cache = GetGeosphereCache();
+		std::lock_guard<std::mutex> lock(cache.m_mutex);
+
+		std::unique_ptr<GeosphereTopology>& level = cache.m_levels[numSubdivisions];
+		if (!level)
+		{
+			level.reset(new GeosphereTopology());
+			level->m_storage = build();
+			level->m_vertices = level->m_storage.m_vertices.data();
+			level->m_indices = level->m_storage.m_indices32.data();
+			level->m_vertexCount = (uint32)level->m_storage.m_vertices.size();
+			level->m_indexCount = (uint32)level->m_storage.m_indices32.size();
+		}
+
+		return *level;
+	}
+
+	// Caps for the tessellations chosen from a TessellationTarget when neither the error nor
+	// the budget limits them.
+	const uint32 s_maxTargetSlices = 1024;
+	const uint32 s_maxTargetStacks = 512;
+
+	// The error a TessellationTarget allows, in world units.
+	float TargetChordalError(const GeometryGenerator::TessellationTarget& target)
+	{
+		return target.m_pixelsPerUnit > 0.0f ? target.m_maxError / target.m_pixelsPerUnit : target.m_maxError;
+	}
+
+	// Largest distance between a triangle with its corners on the unit sphere and the
+	// sphere, which is reached where the sphere's normal meets the triangle's plane.
+	float UnitSphereChordalError(DirectX::FXMVECTOR a, DirectX::FXMVECTOR b, DirectX::FXMVECTOR c)
+	{
+		DirectX::XMVECTOR n = DirectX::XMVector3Normalize(
+			DirectX::XMVector3Cross(DirectX::XMVectorSubtract(b, a), DirectX::XMVectorSubtract(c, a)));
+
+		return 1.0f - fabsf(DirectX::XMVectorGetX(DirectX::XMVector3Dot(n, a)));
+	}
+
+	DirectX::XMVECTOR UnitSpherePoint(float phi, float theta)
+	{
+		return DirectX::XMVectorSet(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta), 0.0f);
+	}
+
+	// The error of CreateSphere on the unit sphere.  Every triangle of a stack is a rotated
+	// copy of the first quad's, and the stacks below the equator mirror those above it.
+	float SphereChordalError(uint32 sliceCount, uint32 stackCount)
+	{
+		float phiStep = DirectX::XM_PI / stackCount;
+		float thetaStep = DirectX::XM_2PI / sliceCount;
+
+		DirectX::XMVECTOR pole = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		float error = UnitSphereChordalError(pole, UnitSpherePoint(phiStep, thetaStep), UnitSpherePoint(phiStep, 0.0f));
+
+		for (uint32 i = 1; i < (stackCount + 1) / 2; ++i)
+		{
+			DirectX::XMVECTOR p00 = UnitSpherePoint(i * phiStep, 0.0f);
+			DirectX::XMVECTOR p01 = UnitSpherePoint(i * phiStep, thetaStep);
+			DirectX::XMVECTOR p10 = UnitSpherePoint((i + 1) * phiStep, 0.0f);
+			DirectX::XMVECTOR p11 = UnitSpherePoint((i + 1) * phiStep, thetaStep);
+
+			error = std::max(error, UnitSphereChordalError(p00, p01, p10));
+			error = std::max(error, UnitSphereChordalError(p10, p01, p11));
+		}
+
+		return error;
+	}
+
+	float GeosphereChordalError(const GeosphereTopology& unit)
+	{
+		float error = 0.0f;
+		for (uint32 i = 0; i < unit.m_indexCount; i += 3)
+		{
+			error = std::max(error, UnitSphereChordalError(
+				DirectX::XMLoadFloat3(&unit.m_vertices[unit.m_indices[i]].m_position),
+				DirectX::XMLoadFloat3(&unit.m_vertices[unit.m_indices[i + 1]].m_position),
+				DirectX::XMLoadFloat3(&unit.m_vertices[unit.m_indices[i + 2]].m_position)));
+		}
+
+		return error;
+	}
+
+	// Symmetric 4x4 error quadric of Garland and Heckbert, summing squared distances
+	// to a set of planes.
+	struct Quadric
+	{
+		double m_a2 = 0.0, m_ab = 0.0, m_ac = 0.0, m_ad = 0.0;
+		double m_b2 = 0.0, m_bc = 0.0, m_bd = 0.0;
+		double m_c2 = 0.0, m_cd = 0.0;
+		double m_d2 = 0.0;
+
+		void AddPlane(double a, double b, double c, double d, double weight)
+		{
+			m_a2 += weight * a * a; m_ab += weight * a * b; m_ac += weight * a * c; m_ad += weight * a * d;
+			m_b2 += weight * b * b; m_bc += weight * b * c; m_bd += weight * b * d;
+			m_c2 += weight * c * c; m_cd += weight * c * d;
+			m_d2 += weight * d * d;
+		}
+
+		void Add(const Quadric& q)
+		{
+			m_a2 += q.m_a2; m_ab += q.m_ab; m_ac += q.m_ac; m_ad += q.m_ad;
+			m_b2 += q.m_b2; m_bc += q.m_bc; m_bd += q.m_bd;
+			m_c2 += q.m_c2; m_cd += q.m_cd;
+			m_d2 += q.m_d2;
+		}
+
+		// Sum of the weighted squared distances from p to the planes.
+		double Error(const DirectX::XMFLOAT3& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			return m_a2 * x * x + 2.0 * m_ab * x * y + 2.0 * m_ac * x * z + 2.0 * m_ad * x
+				+ m_b2 * y * y + 2.0 * m_bc * y * z + 2.0 * m_bd * y
+				+ m_c2 * z * z + 2.0 * m_cd * z
+				+ m_d2;
+		}
+	};
+
+	std::uint64_t EdgeKey(uint32 i0, uint32 i1)
+	{
+		return i0 < i1
+			? ((std::uint64_t)i0 << 32) | i1
+			: ((std::uint64_t)i1 << 32) | i0;
+	}
+
+	DirectX::XMVECTOR TriangleNormal(const DirectX::XMFLOAT3& p0, const DirectX::XMFLOAT3& p1, const DirectX::XMFLOAT3& p2)
+	{
+		DirectX::XMVECTOR v0 = DirectX::XMLoadFloat3(&p0);
+		DirectX::XMVECTOR e0 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&p1), v0);
+		DirectX::XMVECTOR e1 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&p2), v0);
+
+		return DirectX::XMVector3Cross(e0, e1);
+	}
+
+	// A unit vector perpendicular to v, for when a tangent cannot be derived.
+	DirectX::XMVECTOR AnyPerpendicular(DirectX::FXMVECTOR v)
+	{
+		DirectX::XMFLOAT3 a;
+		DirectX::XMStoreFloat3(&a, DirectX::XMVectorAbs(v));
+
+		// Cross with the axis v is least aligned with.
+		DirectX::XMVECTOR axis = a.x <= a.y && a.x <= a.z ? DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f)
+			: a.y <= a.z ? DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) : DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+
+		return DirectX::XMVector3Normalize(DirectX::XMVector3Cross(v, axis));
+	}
+
+	// Octahedral encoding of a direction: project it onto the octahedron |x| + |y| + |z| = 1
+	// and fold the lower half over the diagonals, leaving a point in [-1, 1]^2.
+	DirectX::XMVECTOR OctahedralEncode(DirectX::FXMVECTOR v)
+	{
+		DirectX::XMVECTOR one = DirectX::XMVectorSplatOne();
+		DirectX::XMVECTOR zero = DirectX::XMVectorZero();
+
+		DirectX::XMVECTOR l1 = DirectX::XMVector3Dot(DirectX::XMVectorAbs(v), one);
+		DirectX::XMVECTOR p = DirectX::XMVectorDivide(v, DirectX::XMVectorMax(l1, DirectX::XMVectorReplicate(FLT_MIN)));
+
+		DirectX::XMVECTOR sign = DirectX::XMVectorSelect(DirectX::XMVectorNegate(one), one, DirectX::XMVectorGreaterOrEqual(p, zero));
+		DirectX::XMVECTOR folded = DirectX::XMVectorMultiply(
+			DirectX::XMVectorSubtract(one, DirectX::XMVectorAbs(DirectX::XMVectorSwizzle<1, 0, 2, 3>(p))), sign);
+
+		return DirectX::XMVectorSelect(p, folded, DirectX::XMVectorLess(DirectX::XMVectorSplatZ(p), zero));
+	}
+
+	DirectX::XMVECTOR OctahedralDecode(DirectX::FXMVECTOR e)
+	{
+		DirectX::XMVECTOR one = DirectX::XMVectorSplatOne();
+
+		DirectX::XMVECTOR a = DirectX::XMVectorAbs(e);
+		DirectX::XMVECTOR z = DirectX::XMVectorSubtract(one, DirectX::XMVectorAdd(DirectX::XMVectorSplatX(a), DirectX::XMVectorSplatY(a)));
+
+		// Unfold the lower half: move x and y towards zero by the depth below the equator.
+		DirectX::XMVECTOR t = DirectX::XMVectorSaturate(DirectX::XMVectorNegate(z));
+		DirectX::XMVECTOR sign = DirectX::XMVectorSelect(DirectX::XMVectorNegate(one), one,
+			DirectX::XMVectorGreaterOrEqual(e, DirectX::XMVectorZero()));
+		DirectX::XMVECTOR xy = DirectX::XMVectorNegativeMultiplySubtract(sign, t, e);
+
+		return DirectX::XMVector3Normalize(DirectX::XMVectorSelect(xy, z, DirectX::XMVectorSelectControl(0, 0, 1, 0)));
+	}
+
+	// Angle in degrees between a direction and its decoded version, or zero if the
+	// original has no direction to preserve.
+	float DirectionError(const DirectX::XMFLOAT3& original, DirectX::FXMVECTOR decoded)
+	{
+		DirectX::XMVECTOR v = DirectX::XMLoadFloat3(&original);
+		if (DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(v)) == 0.0f)
+			return 0.0f;
+
+		float cosAngle = DirectX::XMVectorGetX(DirectX::XMVector3Dot(DirectX::XMVector3Normalize(v), decoded));
+		return DirectX::XMConvertToDegrees(acosf(std::min(std::max(cosAngle, -1.0f), 1.0f)));
+	}
+
+	// Spatial hash cell of a coordinate for Weld.  With no tolerance every distinct value
+	// gets its own cell: its bit pattern, with -0 folded into +0.
+	std::int32_t WeldCell(float x, float invCellSize)
+	{
+		if (invCellSize == 0.0f)
+		{
+			x += 0.0f;
+
+			std::int32_t bits;
+			std::memcpy(&bits, &x, sizeof(bits));
+			return bits;
+		}
+
+		double cell = std::floor((double)x * invCellSize);
+		return (std::int32_t)std::min(std::max(cell, (double)INT32_MIN), (double)INT32_MAX);
+	}
+
+	std::uint32_t WeldCellHash(std::int32_t x, std::int32_t y, std::int32_t z)
+	{
+		// Teschner et al., "Optimized Spatial Hashing for Collision Detection of Deformable Objects",
+		// followed by the MurmurHash3 finalizer.  The table index is taken from the low bits,
+		// and neither lattice coordinates nor float bit patterns vary much there.
+		std::uint32_t h = ((std::uint32_t)x * 73856093u) ^ ((std::uint32_t)y * 19349663u) ^ ((std::uint32_t)z * 83492791u);
+		h ^= h >> 16;
+		h *= 0x85ebca6bu;
+		h ^= h >> 13;
+		h *= 0xc2b2ae35u;
+		h ^= h >> 16;
+		return h;
+	}
+
+	// How many vertices ahead Weld prefetches the hash slot it will probe.
+	const uint32 s_weldPrefetchDistance = 16;
+
+	// Starts loading the cache line holding p so a later access does not stall on it.
+	void Prefetch(const void* p)
+	{
+#if defined(_XM_SSE_INTRINSICS_)
+		_mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+		(void)p;
+#endif
+	}
+
+	// A slot of Weld's spatial hash: a cell and the last vertex kept in it.
+	struct WeldCellSlot
+	{
+		std::int32_t m_x;
+		std::int32_t m_y;
+		std::int32_t m_z;
+		uint32 m_head;
+	};
+
+	bool WithinTolerance(const float* a, const float* b, uint32 count, float epsilon)
+	{
+		for (uint32 i = 0; i < count; ++i)
+		{
+			if (!(std::fabs(a[i] - b[i]) <= epsilon))
+				return false;
+		}
+
+		return true;
+	}
+
+	// Bounding box of count points plus a sphere around the box center that reaches
+	// the farthest point.  position(i) returns the ith point.
+	template<typename Position>
+	void ComputePointBounds(uint32 count, const Position& position, DirectX::BoundingBox& box, DirectX::BoundingSphere& sphere)
+	{
+		if (count == 0)
+		{
+			box = DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
+			sphere = DirectX::BoundingSphere(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f);
+			return;
+		}
+
+		// Reduce two points per iteration into independent accumulators so
+		// consecutive min/max operations do not wait on each other.
+		DirectX::XMVECTOR vMin0 = DirectX::XMVectorReplicate(+FLT_MAX);
+		DirectX::XMVECTOR vMax0 = DirectX::XMVectorReplicate(-FLT_MAX);
+		DirectX::XMVECTOR vMin1 = vMin0;
+		DirectX::XMVECTOR vMax1 = vMax0;
+
+		uint32 i = 0;
+		for (; i + 1 < count; i += 2)
+		{
+			DirectX::XMVECTOR p0 = position(i);
+			DirectX::XMVECTOR p1 = position(i + 1);
+
+			vMin0 = DirectX::XMVectorMin(vMin0, p0);
+			vMax0 = DirectX::XMVectorMax(vMax0, p0);
+			vMin1 = DirectX::XMVectorMin(vMin1, p1);
+			vMax1 = DirectX::XMVectorMax(vMax1, p1);
+		}
+
+		if (i < count)
+		{
+			DirectX::XMVECTOR p = position(i);
+			vMin0 = DirectX::XMVectorMin(vMin0, p);
+			vMax0 = DirectX::XMVectorMax(vMax0, p);
+		}
+
+		DirectX::XMVECTOR vMin = DirectX::XMVectorMin(vMin0, vMin1);
+		DirectX::XMVECTOR vMax = DirectX::XMVectorMax(vMax0, vMax1);
+
+		DirectX::BoundingBox::CreateFromPoints(box, vMin, vMax);
+
+		DirectX::XMVECTOR center = DirectX::XMVectorScale(DirectX::XMVectorAdd(vMin, vMax), 0.5f);
+		DirectX::XMVECTOR maxDistSq = DirectX::XMVectorZero();
+
+		for (i = 0; i < count; ++i)
+		{
+			DirectX::XMVECTOR d = DirectX::XMVectorSubtract(position(i), center);
+			maxDistSq = DirectX::XMVectorMax(maxDistSq, DirectX::XMVector3LengthSq(d));
+		}
+
+		DirectX::XMStoreFloat3(&sphere.Center, center);
+		sphere.Radius = sqrtf(DirectX::XMVectorGetX(maxDistSq));
+	}
+
+	// Permutation of 0-255 for hashing gradient noise lattice points, stored twice so a
+	// lookup offset by up to 255 needs no wrapping.
+	struct NoisePermutation
+	{
+		explicit NoisePermutation(uint32 seed)
+		{
+			for (uint32 i = 0; i < 256; ++i)
+				m_p[i] = (std::uint8_t)i;
+
+			// Fisher-Yates shuffle driven by xorshift32.
+			uint32 state = seed * 2654435761u + 0x9e3779b9u;
+			for (uint32 i = 255; i > 0; --i)
+			{
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				std::swap(m_p[i], m_p[state % (i + 1)]);
+			}
+
+			std::memcpy(m_p + 256, m_p, 256);
+		}
+
+		std::uint8_t m_p[512];
+	};
+
+	// Gradient directions, indexed by the low three bits of a lattice hash.
+	const float s_noiseGradientX[8] = { 1.0f, -1.0f, 0.0f, 0.0f, 0.70710678f, -0.70710678f, 0.70710678f, -0.70710678f };
+	const float s_noiseGradientY[8] = { 0.0f, 0.0f, 1.0f, -1.0f, 0.70710678f, 0.70710678f, -0.70710678f, -0.70710678f };
+
+	// 2D gradient noise at four points at once, with its partial derivatives.  Only the
+	// lattice hashing is done lane by lane; the interpolation and its derivatives run
+	// on whole vectors.
+	void GradientNoise4(const NoisePermutation& perm, DirectX::FXMVECTOR x, DirectX::FXMVECTOR y,
+		DirectX::XMVECTOR& value, DirectX::XMVECTOR& ddx, DirectX::XMVECTOR& ddy)
+	{
+		DirectX::XMVECTOR cellX = DirectX::XMVectorFloor(x);
+		DirectX::XMVECTOR cellY = DirectX::XMVectorFloor(y);
+		DirectX::XMVECTOR fx = DirectX::XMVectorSubtract(x, cellX);
+		DirectX::XMVECTOR fy = DirectX::XMVectorSubtract(y, cellY);
+
+		DirectX::XMFLOAT4 cx, cy;
+		DirectX::XMStoreFloat4(&cx, cellX);
+		DirectX::XMStoreFloat4(&cy, cellY);
+
+		// Gradients at the four corners of each point's cell.
+		DirectX::XMFLOAT4 g00x, g00y, g10x, g10y, g01x, g01y, g11x, g11y;
+		for (uint32 lane = 0; lane < 4; ++lane)
+		{
+			uint32 ix = (uint32)(std::int32_t)(&cx.x)[lane] & 255;
+			uint32 iy = (uint32)(std::int32_t)(&cy.x)[lane] & 255;
+
+			uint32 h00 = perm.m_p[perm.m_p[ix] + iy] & 7;
+			uint32 h10 = perm.m_p[perm.m_p[ix + 1] + iy] & 7;
+			uint32 h01 = perm.m_p[perm.m_p[ix] + iy + 1] & 7;
+			uint32 h11 = perm.m_p[perm.m_p[ix + 1] + iy + 1] & 7;
+
+			(&g00x.x)[lane] = s_noiseGradientX[h00]; (&g00y.x)[lane] = s_noiseGradientY[h00];
+			(&g10x.x)[lane] = s_noiseGradientX[h10]; (&g10y.x)[lane] = s_noiseGradientY[h10];
+			(&g01x.x)[lane] = s_noiseGradientX[h01]; (&g01y.x)[lane] = s_noiseGradientY[h01];
+			(&g11x.x)[lane] = s_noiseGradientX[h11]; (&g11y.x)[lane] = s_noiseGradientY[h11];
+		}
+
+		DirectX::XMVECTOR ax = DirectX::XMLoadFloat4(&g00x), ay = DirectX::XMLoadFloat4(&g00y);
+		DirectX::XMVECTOR bx = DirectX::XMLoadFloat4(&g10x), by = DirectX::XMLoadFloat4(&g10y);
+		DirectX::XMVECTOR cx4 = DirectX::XMLoadFloat4(&g01x), cy4 = DirectX::XMLoadFloat4(&g01y);
+		DirectX::XMVECTOR dx4 = DirectX::XMLoadFloat4(&g11x), dy4 = DirectX::XMLoadFloat4(&g11y);
+
+		// Each corner's gradient dotted with the offset from that corner.
+		DirectX::XMVECTOR one = DirectX::XMVectorSplatOne();
+		DirectX::XMVECTOR fx1 = DirectX::XMVectorSubtract(fx, one);
+		DirectX::XMVECTOR fy1 = DirectX::XMVectorSubtract(fy, one);
+
+		DirectX::XMVECTOR va = DirectX::XMVectorMultiplyAdd(ax, fx, DirectX::XMVectorMultiply(ay, fy));
+		DirectX::XMVECTOR vb = DirectX::XMVectorMultiplyAdd(bx, fx1, DirectX::XMVectorMultiply(by, fy));
+		DirectX::XMVECTOR vc = DirectX::XMVectorMultiplyAdd(cx4, fx, DirectX::XMVectorMultiply(cy4, fy1));
+		DirectX::XMVECTOR vd = DirectX::XMVectorMultiplyAdd(dx4, fx1, DirectX::XMVectorMultiply(dy4, fy1));
+
+		// Quintic fade u = f^3 (f (6f - 15) + 10) and its derivative 30 f^2 (f - 1)^2.
+		auto fade = [](DirectX::FXMVECTOR f)
+		{
+			DirectX::XMVECTOR inner = DirectX::XMVectorMultiplyAdd(f, DirectX::XMVectorReplicate(6.0f), DirectX::XMVectorReplicate(-15.0f));
+			inner = DirectX::XMVectorMultiplyAdd(f, inner, DirectX::XMVectorReplicate(10.0f));
+			return DirectX::XMVectorMultiply(DirectX::XMVectorMultiply(DirectX::XMVectorMultiply(f, f), f), inner);
+		};
+		auto fadeDerivative = [](DirectX::FXMVECTOR f, DirectX::FXMVECTOR f1)
+		{
+			DirectX::XMVECTOR ff1 = DirectX::XMVectorMultiply(f, f1);
+			return DirectX::XMVectorScale(DirectX::XMVectorMultiply(ff1, ff1), 30.0f);
+		};
+
+		DirectX::XMVECTOR ux = fade(fx);
+		DirectX::XMVECTOR uy = fade(fy);
+		DirectX::XMVECTOR dux = fadeDerivative(fx, fx1);
+		DirectX::XMVECTOR duy = fadeDerivative(fy, fy1);
+		DirectX::XMVECTOR uxy = DirectX::XMVectorMultiply(ux, uy);
+
+		DirectX::XMVECTOR ba = DirectX::XMVectorSubtract(vb, va);
+		DirectX::XMVECTOR ca = DirectX::XMVectorSubtract(vc, va);
+		DirectX::XMVECTOR k = DirectX::XMVectorAdd(DirectX::XMVectorSubtract(DirectX::XMVectorSubtract(va, vb), vc), vd);
+
+		// value = va + ux (vb - va) + uy (vc - va) + ux uy k
+		value = DirectX::XMVectorMultiplyAdd(uxy, k,
+			DirectX::XMVectorMultiplyAdd(uy, ca, DirectX::XMVectorMultiplyAdd(ux, ba, va)));
+
+		// The same blend of the gradients, plus the change of the blend weights.
+		auto blend = [&](DirectX::FXMVECTOR a, DirectX::FXMVECTOR b, DirectX::FXMVECTOR c, DirectX::GXMVECTOR d)
+		{
+			DirectX::XMVECTOR kd = DirectX::XMVectorAdd(DirectX::XMVectorSubtract(DirectX::XMVectorSubtract(a, b), c), d);
+			return DirectX::XMVectorMultiplyAdd(uxy, kd, DirectX::XMVectorMultiplyAdd(uy, DirectX::XMVectorSubtract(c, a),
+				DirectX::XMVectorMultiplyAdd(ux, DirectX::XMVectorSubtract(b, a), a)));
+		};
+
+		ddx = DirectX::XMVectorMultiplyAdd(dux, DirectX::XMVectorMultiplyAdd(uy, k, ba), blend(ax, bx, cx4, dx4));
+		ddy = DirectX::XMVectorMultiplyAdd(duy, DirectX::XMVectorMultiplyAdd(ux, k, ca), blend(ay, by, cy4, dy4));
+	}
+
+	// Builds the tiles of CreateGridTiles displaced by a height field, each with a skirt
+	// hanging skirtDepth below its border.  sampleRow(i, j0, count, h, dhdx, dhdz) fills
+	// the heights and their x and z derivatives of count vertices of grid row i starting
+	// at column j0, and is called from several threads at once.
+	template<typename SampleRow>
+	std::vector<GeometryGenerator::MeshData> BuildTerrainTiles(std::pmr::memory_resource* resource,
+		float width, float depth, uint32 m, uint32 n, uint32 tileQuads, float skirtDepth, const SampleRow& sampleRow)
+	{
+		GridLayout grid(width, depth, m, n);
+		GridTiling tiling(m, n, tileQuads);
+
+		// Size every tile up front so the memory resource is only used from this thread.
+		// The skirt duplicates the border loop of the tile, one quad per border edge.
+		std::vector<GeometryGenerator::MeshData> tiles;
+		tiles.reserve(tiling.TileCount());
+		for (uint32 t = 0; t < tiling.TileCount(); ++t)
+		{
+			uint32 i0, j0, tileM, tileN;
+			tiling.Range(t, i0, j0, tileM, tileN);
+
+			uint32 borderCount = 2 * (tileM - 1) + 2 * (tileN - 1);
+
+			tiles.emplace_back(resource);
+			tiles.back().m_vertices.resize(tileM * tileN + borderCount);
+			tiles.back().m_indices32.resize((tileM - 1) * (tileN - 1) * 6 + borderCount * 6);
+		}
+
+		ParallelFor(tiling.TileCount(), 1, [&](uint32 tileBegin, uint32 tileEnd)
+		{
+			std::vector<float> heights;
+			std::vector<float> dhdx;
+			std::vector<float> dhdz;
+
+			for (uint32 t = tileBegin; t < tileEnd; ++t)
+			{
+				uint32 i0, j0, tileM, tileN;
+				tiling.Range(t, i0, j0, tileM, tileN);
+
+				GeometryGenerator::MeshData& tile = tiles[t];
+
+				heights.resize(tileN);
+				dhdx.resize(tileN);
+				dhdz.resize(tileN);
+
+				for (uint32 i = 0; i < tileM; ++i)
+				{
+					sampleRow(i0 + i, j0, tileN, heights.data(), dhdx.data(), dhdz.data());
+
+					for (uint32 j = 0; j < tileN; ++j)
+					{
+						// The surface is y = h(x, z), so its normal is (-dh/dx, 1, -dh/dz)
+						// and the tangent along +x, the direction of increasing u, is (1, dh/dx, 0).
+						GeometryGenerator::Vertex& v = tile.m_vertices[i * tileN + j];
+						v = grid.At(i0 + i, j0 + j);
+						v.m_position.y = heights[j];
+
+						DirectX::XMStoreFloat3(&v.m_normal,
+							DirectX::XMVector3Normalize(DirectX::XMVectorSet(-dhdx[j], 1.0f, -dhdz[j], 0.0f)));
+						DirectX::XMStoreFloat3(&v.m_tangentU,
+							DirectX::XMVector3Normalize(DirectX::XMVectorSet(1.0f, dhdx[j], 0.0f, 0.0f)));
+					}
+				}
+
+				uint32 k = 0;
+				for (uint32 i = 0; i < tileM - 1; ++i)
+				{
+					for (uint32 j = 0; j < tileN - 1; ++j)
+					{
+						tile.m_indices32[k] = i * tileN + j;
+						tile.m_indices32[k + 1] = i * tileN + j + 1;
+						tile.m_indices32[k + 2] = (i + 1) * tileN + j;
+
+						tile.m_indices32[k + 3] = (i + 1) * tileN + j;
+						tile.m_indices32[k + 4] = i * tileN + j + 1;
+						tile.m_indices32[k + 5] = (i + 1) * tileN + j + 1;
+
+						k += 6; // next quad
+					}
+				}
+
+				//
+				// Walk the border clockwise seen from above, starting at the far left
+				// corner, and drop a copy of each border vertex by skirtDepth.
+				//
+
+				uint32 borderCount = 2 * (tileM - 1) + 2 * (tileN - 1);
+				uint32 skirtBase = tileM * tileN;
+
+				auto borderVertex = [&](uint32 b)
+				{
+					if (b < tileN - 1)
+						return b;
+					b -= tileN - 1;
+					if (b < tileM - 1)
+						return b * tileN + tileN - 1;
+					b -= tileM - 1;
+					if (b < tileN - 1)
+						return (tileM - 1) * tileN + tileN - 1 - b;
+					b -= tileN - 1;
+					return (tileM - 1 - b) * tileN;
+				};
+
+				for (uint32 b = 0; b < borderCount; ++b)
+				{
+					GeometryGenerator::Vertex& skirt = tile.m_vertices[skirtBase + b];
+					skirt = tile.m_vertices[borderVertex(b)];
+					skirt.m_position.y -= skirtDepth;
+				}
+
+				for (uint32 b = 0; b < borderCount; ++b)
+				{
+					uint32 next = (b + 1) % borderCount;
+
+					uint32 top0 = borderVertex(b);
+					uint32 top1 = borderVertex(next);
+					uint32 bottom0 = skirtBase + b;
+					uint32 bottom1 = skirtBase + next;
+
+					tile.m_indices32[k] = top0;
+					tile.m_indices32[k + 1] = bottom1;
+					tile.m_indices32[k + 2] = top1;
+
+					tile.m_indices32[k + 3] = top0;
+					tile.m_indices32[k + 4] = bottom0;
+					tile.m_indices32[k + 5] = bottom1;
+
+					k += 6;
+				}
+
+				ComputePointBounds((uint32)tile.m_vertices.size(),
+					[&tile](uint32 i) { return DirectX::XMLoadFloat3(&tile.m_vertices[i].m_position); },
+					tile.m_boundingBox, tile.m_boundingSphere);
+			}
+		});
+
+		return tiles;
+	}
+}
+
+GeometryGenerator::MeshData::MeshData(std::pmr::memory_resource* resource)
+	: m_vertices(resource),
+	m_indices32(resource),
+	m_indices16(resource)
+{
+}
+
+std::pmr::vector<uint16>& GeometryGenerator::MeshData::GetIndices16()
+{
+	if (m_indices16.empty())
+	{
+		// Truncated indices would draw the wrong vertices without any other sign, so
+		// check them all before converting any, in release builds as well.
+		if (std::any_of(m_indices32.begin(), m_indices32.end(), [](uint32 index) { return index > 0xffff; }))
+		{
+			throw std::out_of_range("MeshData::GetIndices16: an index does not fit in 16 bits; "
+				"split the mesh with GeometryGenerator::PartitionIndices16 first.");
+		}
+
+		m_indices16.resize(m_indices32.size());
+		for (size_t i = 0; i < m_indices32.size(); ++i)
+			m_indices16[i] = static_cast<uint16>(m_indices32[i]);
+	}
+
+	return m_indices16;
+}
+
+GeometryGenerator::AllocationCounter::AllocationCounter(std::pmr::memory_resource* upstream)
+	: m_upstream(upstream)
+{
+}
+
+void GeometryGenerator::AllocationCounter::Reset()
+{
+	m_allocationCount = 0;
+	m_bytesAllocated = 0;
+}
+
+void* GeometryGenerator::AllocationCounter::do_allocate(size_t bytes, size_t alignment)
+{
+	++m_allocationCount;
+	m_bytesAllocated += bytes;
+
+	return m_upstream->allocate(bytes, alignment);
+}
+
+void GeometryGenerator::AllocationCounter::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	m_upstream->deallocate(p, bytes, alignment);
+}
+
+bool GeometryGenerator::AllocationCounter::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+GeometryGenerator::GeometryGenerator(std::pmr::memory_resource* resource)
+	: m_resource(resource)
+{
+}
+
+GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float depth, uint32 m, uint32 n, GridOrder order)
+{
+	MeshData meshData(m_resource);
+
+	uint32 vertexCount = m * n;
+	uint32 faceCount = (m - 1) * (n - 1) * 2;
+
+	GridLayout grid(width, depth, m, n);
+
+	meshData.m_vertices.resize(vertexCount);
+	meshData.m_indices32.resize(faceCount * 3); // 3 indices per face
+
+	if (order != GridOrder::RowMajor)
+	{
+		// Walking the curve is serial, but the vertices it numbers can be filled in parallel.
+		std::pmr::vector<uint32> gridVertex(m_resource);
+		BuildOrderedGridIndices(m, n, order, meshData.m_indices32.data(), gridVertex);
+
+		ParallelFor(vertexCount, s_minVerticesPerTask, [&](uint32 begin, uint32 end)
+		{
+			for (uint32 v = begin; v < end; ++v)
+				meshData.m_vertices[v] = grid.At(gridVertex[v] / n, gridVertex[v] % n);
+		});
+	}
+	else
+	{
+		// Every row writes its own slice of the pre-sized buffers, so the rows can be
+		// filled in parallel without any synchronisation.
+		ParallelFor(m, s_minVerticesPerTask / n + 1, [&](uint32 rowBegin, uint32 rowEnd)
+		{
+			//
+			// Create the vertices.
+			//
+
+			for (uint32 i = rowBegin; i < rowEnd; ++i)
+			{
+				for (uint32 j = 0; j < n; ++j)
+					meshData.m_vertices[i * n + j] = grid.At(i, j);
+			}
+
+			//
+			// Create the indices.
+			//
+
+			// Iterate over each quad and compute indices.
+			for (uint32 i = rowBegin; i < std::min(rowEnd, m - 1); ++i)
+			{
+				uint32 k = i * (n - 1) * 6;
+				for (uint32 j = 0; j < n - 1; ++j)
+				{
+					meshData.m_indices32[k] = i * n + j;
+					meshData.m_indices32[k + 1] = i * n + j + 1;
+					meshData.m_indices32[k + 2] = (i + 1) * n + j;
+
+					meshData.m_indices32[k + 3] = (i + 1) * n + j;
+					meshData.m_indices32[k + 4] = i * n + j + 1;
+					meshData.m_indices32[k + 5] = (i + 1) * n + j + 1;
+
+					k += 6; // next quad
+				}
+			}
+		});
+	}
+
+	meshData.m_boundingBox = DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f),
+		DirectX::XMFLOAT3(grid.m_halfWidth, 0.0f, grid.m_halfDepth));
+	meshData.m_boundingSphere = DirectX::BoundingSphere(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f),
+		sqrtf(grid.m_halfWidth * grid.m_halfWidth + grid.m_halfDepth * grid.m_halfDepth));
+
+	return meshData;
+}
+
+std::vector<GeometryGenerator::MeshData> GeometryGenerator::CreateGridTiles(float width, float depth, uint32 m, uint32 n, uint32 tileQuads,
+	GridOrder order)
+{
+	GridLayout grid(width, depth, m, n);
+	GridTiling tiling(m, n, tileQuads);
+
+	// Size every tile up front so the memory resource is only used from this thread.
+	std::vector<MeshData> tiles;
+	tiles.reserve(tiling.TileCount());
+	for (uint32 t = 0; t < tiling.TileCount(); ++t)
+	{
+		uint32 i0, j0, tileM, tileN;
+		tiling.Range(t, i0, j0, tileM, tileN);
+
+		tiles.emplace_back(m_resource);
+		tiles.back().m_vertices.resize(tileM * tileN);
+		tiles.back().m_indices32.resize((tileM - 1) * (tileN - 1) * 6);
+	}
+
+	ParallelFor((uint32)tiles.size(), 1, [&](uint32 tileBegin, uint32 tileEnd)
+	{
+		// On the heap: m_resource need not be thread safe, and this runs on the workers.
+		std::pmr::vector<uint32> gridVertex(std::pmr::new_delete_resource());
+
+		for (uint32 t = tileBegin; t < tileEnd; ++t)
+		{
+			uint32 i0, j0, tileM, tileN;
+			tiling.Range(t, i0, j0, tileM, tileN);
+
+			MeshData& tile = tiles[t];
+
+			if (order != GridOrder::RowMajor)
+			{
+				BuildOrderedGridIndices(tileM, tileN, order, tile.m_indices32.data(), gridVertex);
+
+				for (uint32 v = 0; v < tileM * tileN; ++v)
+					tile.m_vertices[v] = grid.At(i0 + gridVertex[v] / tileN, j0 + gridVertex[v] % tileN);
+			}
+			else
+			{
+				for (uint32 i = 0; i < tileM; ++i)
+				{
+					for (uint32 j = 0; j < tileN; ++j)
+						tile.m_vertices[i * tileN + j] = grid.At(i0 + i, j0 + j);
+				}
+
+				uint32 k = 0;
+				for (uint32 i = 0; i < tileM - 1; ++i)
+				{
+					for (uint32 j = 0; j < tileN - 1; ++j)
+					{
+						tile.m_indices32[k] = i * tileN + j;
+						tile.m_indices32[k + 1] = i * tileN + j + 1;
+						tile.m_indices32[k + 2] = (i + 1) * tileN + j;
+
+						tile.m_indices32[k + 3] = (i + 1) * tileN + j;
+						tile.m_indices32[k + 4] = i * tileN + j + 1;
+						tile.m_indices32[k + 5] = (i + 1) * tileN + j + 1;
+
+						k += 6; // next quad
+					}
+				}
+			}
+
+			ComputeBounds(tile);
+		}
+	});
+
+	return tiles;
+}
+
+std::vector<GeometryGenerator::MeshData> GeometryGenerator::CreateTerrainTiles(float width, float depth, uint32 m, uint32 n,
+	uint32 tileQuads, const TerrainNoise& noise, float skirtDepth)
+{
+	NoisePermutation perm(noise.m_seed);
+	GridLayout grid(width, depth, m, n);
+
+	auto sampleRow = [&](uint32 i, uint32 j0, uint32 count, float* heights, float* dhdx, float* dhdz)
+	{
+		DirectX::XMVECTOR z = DirectX::XMVectorReplicate(grid.m_halfDepth - i * grid.m_dz);
+
+		// Four vertices of the row per iteration.  The last group may run past the end of
+		// the row and only keeps the lanes that exist.
+		for (uint32 j = 0; j < count; j += 4)
+		{
+			float x0 = -grid.m_halfWidth + (j0 + j) * grid.m_dx;
+			DirectX::XMVECTOR x = DirectX::XMVectorAdd(DirectX::XMVectorReplicate(x0),
+				DirectX::XMVectorScale(DirectX::XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f), grid.m_dx));
+
+			DirectX::XMVECTOR h = DirectX::XMVectorZero();
+			DirectX::XMVECTOR hx = DirectX::XMVectorZero();
+			DirectX::XMVECTOR hz = DirectX::XMVectorZero();
+
+			float frequency = noise.m_frequency;
+			float amplitude = noise.m_amplitude;
+			for (uint32 octave = 0; octave < noise.m_octaves; ++octave)
+			{
+				// Shift each octave so their lattices, and the zeros at the lattice
+				// points, do not line up.
+				DirectX::XMVECTOR offset = DirectX::XMVectorReplicate(octave * 17.31f);
+				DirectX::XMVECTOR value, ddx, ddz;
+				GradientNoise4(perm,
+					DirectX::XMVectorMultiplyAdd(x, DirectX::XMVectorReplicate(frequency), offset),
+					DirectX::XMVectorMultiplyAdd(z, DirectX::XMVectorReplicate(frequency), offset),
+					value, ddx, ddz);
+
+				h = DirectX::XMVectorMultiplyAdd(value, DirectX::XMVectorReplicate(amplitude), h);
+				hx = DirectX::XMVectorMultiplyAdd(ddx, DirectX::XMVectorReplicate(amplitude * frequency), hx);
+				hz = DirectX::XMVectorMultiplyAdd(ddz, DirectX::XMVectorReplicate(amplitude * frequency), hz);
+
+				frequency *= noise.m_lacunarity;
+				amplitude *= noise.m_gain;
+			}
+
+			DirectX::XMFLOAT4 h4, hx4, hz4;
+			DirectX::XMStoreFloat4(&h4, h);
+			DirectX::XMStoreFloat4(&hx4, hx);
+			DirectX::XMStoreFloat4(&hz4, hz);
+
+			for (uint32 lane = 0; lane < 4 && j + lane < count; ++lane)
+			{
+				heights[j + lane] = (&h4.x)[lane];
+				dhdx[j + lane] = (&hx4.x)[lane];
+				dhdz[j + lane] = (&hz4.x)[lane];
+			}
+		}
+	};
+
+	return BuildTerrainTiles(m_resource, width, depth, m, n, tileQuads, skirtDepth, sampleRow);
+}
+
+std::vector<GeometryGenerator::MeshData> GeometryGenerator::CreateTerrainTiles(float width, float depth, uint32 m, uint32 n,
+	uint32 tileQuads, const float* heights, float heightScale, float skirtDepth)
+{
+	GridLayout grid(width, depth, m, n);
+
+	// Central differences, one sided at the edges of the map.  Row i lies at
+	// z = halfDepth - i * dz, so z grows towards row i - 1.
+	auto sampleRow = [&](uint32 i, uint32 j0, uint32 count, float* h, float* dhdx, float* dhdz)
+	{
+		const float* row = heights + (size_t)i * n;
+		const float* rowAbove = heights + (size_t)(i > 0 ? i - 1 : i) * n;
+		const float* rowBelow = heights + (size_t)(i + 1 < m ? i + 1 : i) * n;
+		float dzScale = heightScale / (((i > 0) + (i + 1 < m)) * grid.m_dz);
+
+		for (uint32 c = 0; c < count; ++c)
+		{
+			uint32 j = j0 + c;
+			uint32 left = j > 0 ? j - 1 : j;
+			uint32 right = j + 1 < n ? j + 1 : j;
+
+			h[c] = row[j] * heightScale;
+			dhdx[c] = (row[right] - row[left]) * heightScale / ((right - left) * grid.m_dx);
+			dhdz[c] = (rowAbove[j] - rowBelow[j]) * dzScale;
+		}
+	};
+
+	return BuildTerrainTiles(m_resource, width, depth, m, n, tileQuads, skirtDepth, sampleRow);
+}
+
+GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions)
+{
+	MeshData meshData(m_resource);
+
+	float w2 = 0.5f * width;
+	float h2 = 0.5f * height;
+	float d2 = 0.5f * depth;
+
+	// Start from the unit box and stretch it to the requested dimensions.
+	meshData.m_vertices.assign(std::begin(GeometryTables::s_unitBoxVertices), std::end(GeometryTables::s_unitBoxVertices));
+	meshData.m_indices32.assign(std::begin(GeometryTables::s_boxIndices), std::end(GeometryTables::s_boxIndices));
+
+	if (width != 1.0f || height != 1.0f || depth != 1.0f)
+	{
+		for (Vertex& v : meshData.m_vertices)
+		{
+			v.m_position.x *= width;
+			v.m_position.y *= height;
+			v.m_position.z *= depth;
+		}
+	}
+
+	// Put a cap on the number of subdivisions.
+	numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
+
+	for (uint32 i = 0; i < numSubdivisions; ++i)
+		Subdivide(meshData);
+
+	meshData.m_boundingBox = DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(w2, h2, d2));
+	meshData.m_boundingSphere = DirectX::BoundingSphere(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), sqrtf(w2 * w2 + h2 * h2 + d2 * d2));
+
+	return meshData;
+}
+
+GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32 sliceCount, uint32 stackCount)
+{
+	MeshData meshData(m_resource);
+
+	//
+	// Compute the vertices stating at the top pole and moving down the stacks.
+	//
+
+	// Poles: note that there will be texture coordinate distortion as there is
+	// not a unique point on the texture map to assign to the pole when mapping
+	// a rectangular texture onto a sphere.
+	Vertex topVertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	Vertex bottomVertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+
+	float phiStep = DirectX::XM_PI / stackCount;
+	float thetaStep = 2.0f * DirectX::XM_PI / sliceCount;
+
+	// Every ring uses the same set of theta angles, so evaluate them once.
+	std::pmr::vector<float> cosTheta(m_resource);
+	std::pmr::vector<float> sinTheta(m_resource);
+	BuildSliceTable(sliceCount, cosTheta, sinTheta);
+
+	uint32 ringVertexCount = sliceCount + 1;
+
+	meshData.m_vertices.resize((stackCount - 1) * ringVertexCount + 2);
+	meshData.m_vertices.front() = topVertex;
+	meshData.m_vertices.back() = bottomVertex;
+
+	// Compute vertices for each stack ring (do not count the poles as rings).
+	for (uint32 i = 1; i <= stackCount - 1; ++i)
+	{
+		float phi = i * phiStep;
+		float sinPhi = sinf(phi);
+		float cosPhi = cosf(phi);
+
+		Vertex* ring = &meshData.m_vertices[1 + (i - 1) * ringVertexCount];
+
+		// Vertices of ring.
+		for (uint32 j = 0; j <= sliceCount; ++j)
+		{
+			Vertex& v = ring[j];
+
+			// spherical to cartesian, where the normal is the point on the unit sphere
+			v.m_normal.x = sinPhi * cosTheta[j];
+			v.m_normal.y = cosPhi;
+			v.m_normal.z = sinPhi * sinTheta[j];
+
+			v.m_position.x = radius * v.m_normal.x;
+			v.m_position.y = radius * v.m_normal.y;
+			v.m_position.z = radius * v.m_normal.z;
+
+			// Partial derivative of P with respect to theta, which has length
+			// radius * sin(phi) away from the poles.
+			v.m_tangentU.x = -sinTheta[j];
+			v.m_tangentU.y = 0.0f;
+			v.m_tangentU.z = +cosTheta[j];
+
+			v.m_texC.x = (j * thetaStep) / DirectX::XM_2PI;
+			v.m_texC.y = phi / DirectX::XM_PI;
+		}
+	}
+
+	meshData.m_indices32.resize(sliceCount * 6 + (stackCount - 2) * sliceCount * 6);
+	uint32 k = 0;
+
+	//
+	// Compute indices for top stack.  The top stack was written first to the vertex buffer
+	// and connects the top pole to the first ring.
+	//
+
+	for (uint32 i = 1; i <= sliceCount; ++i)
+	{
+		meshData.m_indices32[k++] = 0;
+		meshData.m_indices32[k++] = i + 1;
+		meshData.m_indices32[k++] = i;
+	}
+
+	//
+	// Compute indices for inner stacks (not connected to poles).
+	//
+	uint32 baseIndex = 1;
+	for (uint32 i = 0; i < stackCount - 2; ++i)
+	{
+		for (uint32 j = 0; j < sliceCount; ++j)
+		{
+			meshData.m_indices32[k++] = baseIndex + i * ringVertexCount + j;
+			meshData.m_indices32[k++] = baseIndex + i * ringVertexCount + j + 1;
+			meshData.m_indices32[k++] = baseIndex + (i + 1) * ringVertexCount + j;
+
+			meshData.m_indices32[k++] = baseIndex + (i + 1) * ringVertexCount + j;
+			meshData.m_indices32[k++] = baseIndex + i * ringVertexCount + j + 1;
+			meshData.m_indices32[k++] = baseIndex + (i + 1) * ringVertexCount + j + 1;
+		}
+	}
+
+	//
+	// Compute indices for bottom stack.  The bottom stack was written last to the vertex buffer
+	// and connects the bottom pole to the bottom ring.
+	//
+
+	// South pole vertex was added last.
+	uint32 southPoleIndex = (uint32)meshData.m_vertices.size() - 1;
+
+	// Offset the indices to the index of the first vertex in the last ring.
+	baseIndex = southPoleIndex - ringVertexCount;
+
+	for (uint32 i = 0; i < sliceCount; ++i)
+	{
+		meshData.m_indices32[k++] = southPoleIndex;
+		meshData.m_indices32[k++] = baseIndex + i;
+		meshData.m_indices32[k++] = baseIndex + i + 1;
+	}
+
+	// The poles and the widest ring touch the analytic bounds.
+	meshData.m_boundingBox = DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(radius, radius, radius));
+	meshData.m_boundingSphere = DirectX::BoundingSphere(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), radius);
+
+	return meshData;
+}
+
+GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uint32 numSubdivisions)
+{
+	MeshData meshData(m_resource);
+
+	// Put a cap on the number of subdivisions.
+	numSubdivisions = std::min<uint32>(numSubdivisions, s_maxGeosphereSubdivisions);
+
+	const GeosphereTopology& unit = FindGeosphereTopology(numSubdivisions,
+		[this, numSubdivisions]() { return BuildUnitGeosphere(numSubdivisions); });
+
+	meshData.m_vertices.resize(unit.m_vertexCount);
+	meshData.m_indices32.assign(unit.m_indices, unit.m_indices + unit.m_indexCount);
+
+	// Normals, tangents and texture coordinates do not depend on the radius, so only
+	// the positions need scaling.
+	ParallelFor(unit.m_vertexCount, s_minVerticesPerTask, [&](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; ++i)
+			{
+				Vertex& v = meshData.m_vertices[i];
+				v = unit.m_vertices[i];
+
+				DirectX::XMStoreFloat3(&v.m_position, DirectX::XMVectorScale(DirectX::XMLoadFloat3(&v.m_position), radius));
+			}
+		});
+
+	meshData.m_boundingBox = DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(radius, radius, radius));
+	meshData.m_boundingSphere = DirectX::BoundingSphere(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), radius);
+
+	return meshData;
+}
+
+std::vector<std::uint8_t> GeometryGenerator::SerializeGeosphereTopology(uint32 numSubdivisions)
+{
+	numSubdivisions = std::min<uint32>(numSubdivisions, s_maxGeosphereSubdivisions);
+
+	const GeosphereTopology& unit = FindGeosphereTopology(numSubdivisions,
+		[this, numSubdivisions]() { return BuildUnitGeosphere(numSubdivisions); });
+
+	GeosphereBlobHeader header;
+	header.m_magic = s_geosphereBlobMagic;
+	header.m_version = s_geosphereBlobVersion;
+	header.m_numSubdivisions = numSubdivisions;
+	header.m_vertexCount = unit.m_vertexCount;
+	header.m_indexCount = unit.m_indexCount;
+
+	size_t vertexBytes = unit.m_vertexCount * sizeof(Vertex);
+	size_t indexBytes = unit.m_indexCount * sizeof(uint32);
+
+	std::vector<std::uint8_t> blob(sizeof(header) + vertexBytes + indexBytes);
+	std::memcpy(blob.data(), &header, sizeof(header));
+	std::memcpy(blob.data() + sizeof(header), unit.m_vertices, vertexBytes);
+	std::memcpy(blob.data() + sizeof(header) + vertexBytes, unit.m_indices, indexBytes);
+
+	return blob;
+}
+
+bool GeometryGenerator::LoadGeosphereTopology(const void* data, size_t size)
+{
+	assert(reinterpret_cast<std::uintptr_t>(data) % alignof(uint32) == 0);
+
+	if (data == nullptr || size < sizeof(GeosphereBlobHeader))
+		return false;
+
+	GeosphereBlobHeader header;
+	std::memcpy(&header, data, sizeof(header));
+
+	if (header.m_magic != s_geosphereBlobMagic ||
+		header.m_version != s_geosphereBlobVersion ||
+		header.m_numSubdivisions > s_maxGeosphereSubdivisions ||
+		header.m_vertexCount != GeosphereVertexCount(header.m_numSubdivisions) ||
+		header.m_indexCount != GeosphereIndexCount(header.m_numSubdivisions))
+		return false;
+
+	size_t vertexBytes = header.m_vertexCount * sizeof(Vertex);
+	size_t indexBytes = header.m_indexCount * sizeof(uint32);
+	if (size != sizeof(header) + vertexBytes + indexBytes)
+		return false;
+
+	const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+	const uint32* indices = reinterpret_cast<const uint32*>(bytes + sizeof(header) + vertexBytes);
+
+	for (uint32 i = 0; i < header.m_indexCount; ++i)
+	{
+		if (indices[i] >= header.m_vertexCount)
+			return false;
+	}
+
+	GeosphereCache& cache = GetGeosphereCache();
+	std::lock_guard<std::mutex> lock(cache.m_mutex);
+
+	std::unique_ptr<GeosphereTopology>& level = cache.m_levels[header.m_numSubdivisions];
+	if (level)
+		return false;
+
+	level.reset(new GeosphereTopology());
+	level->m_vertices = reinterpret_cast<const Vertex*>(bytes + sizeof(header));
+	level->m_indices = indices;
+	level->m_vertexCount = header.m_vertexCount;
+	level->m_indexCount = header.m_indexCount;
+
+	return true;
+}
+
+GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount)
+{
+	MeshData meshData(m_resource);
+
+	//
+	// Build Stacks.
+	//
+
+	float stackHeight = height / stackCount;
+
+	// Amount to increment radius as we move up each stack level from bottom to top.
+	float radiusStep = (topRadius - bottomRadius) / stackCount;
+
+	uint32 ringCount = stackCount + 1;
+
+	// Add one because we duplicate the first and last vertex per ring
+	// since the texture coordinates are different.
+	uint32 ringVertexCount = sliceCount + 1;
+
+	// Every ring and both caps use the same set of angles, so evaluate them once.
+	std::pmr::vector<float> cosTheta(m_resource);
+	std::pmr::vector<float> sinTheta(m_resource);
+	BuildSliceTable(sliceCount, cosTheta, sinTheta);
+
+	// Cylinder can be parameterized as follows, where we introduce v
+	// parameter that goes in the same direction as the v tex-coord
+	// so that the bitangent goes in the same direction as the v tex-coord.
+	//   Let r0 be the bottom radius and let r1 be the top radius.
+	/*
+		y(v) = h - hv for v in[0, 1].
+		r(v) = r1 + (r0-r1)v
+
+		x(t, v) = r(v)*cos(t)
+		y(t, v) = h - hv
+		z(t, v) = r(v)*sin(t)
+
+		dx/dt = -r(v)*sin(t)
+		dy/dt = 0
+		dz/dt = +r(v)*cos(t)
+
+		dx/dv = (r0-r1)*cos(t)
+		dy/dv = -h
+		dz/dv = (r0-r1)*sin(t)
+	*/
+
+	// The normal is T x B = (h*cos(t), r0-r1, h*sin(t)), whose length does not
+	// depend on t, so it can be normalised once for the whole side.
+	float dr = bottomRadius - topRadius;
+	float invNormalLength = 1.0f / sqrtf(height * height + dr * dr);
+	float normalXZ = height * invNormalLength;
+	float normalY = dr * invNormalLength;
+
+	// Both caps append a ring and a center vertex after the side.
+	meshData.m_vertices.reserve(ringCount * ringVertexCount + 2 * (ringVertexCount + 1));
+	meshData.m_vertices.resize(ringCount * ringVertexCount);
+
+	// Compute vertices for each stack ring starting at the bottom and moving up.
+	for (uint32 i = 0; i < ringCount; ++i)
+	{
+		float y = -0.5f * height + i * stackHeight;
+		float r = bottomRadius + i * radiusStep;
+
+		Vertex* ring = &meshData.m_vertices[i * ringVertexCount];
+
+		// vertices of ring
+		for (uint32 j = 0; j <= sliceCount; ++j)
+		{
+			Vertex& vertex = ring[j];
+
+			float c = cosTheta[j];
+			float s = sinTheta[j];
+
+			vertex.m_position = DirectX::XMFLOAT3(r * c, y, r * s);
+
+			vertex.m_texC.x = (float)j / sliceCount;
+			vertex.m_texC.y = 1.0f - (float)i / stackCount;
+
+			// This is unit length.
+			vertex.m_tangentU = DirectX::XMFLOAT3(-s, 0.0f, c);
+
+			vertex.m_normal = DirectX::XMFLOAT3(normalXZ * c, normalY, normalXZ * s);
+		}
+	}
+
+	meshData.m_indices32.reserve(stackCount * sliceCount * 6 + 2 * sliceCount * 3);
+	meshData.m_indices32.resize(stackCount * sliceCount * 6);
+
+	// Compute indices for each stack.
+	uint32 k = 0;
+	for (uint32 i = 0; i < stackCount; ++i)
+	{
+		for (uint32 j = 0; j < sliceCount; ++j)
+		{
+			meshData.m_indices32[k++] = i * ringVertexCount + j;
+			meshData.m_indices32[k++] = (i + 1) * ringVertexCount + j;
+			meshData.m_indices32[k++] = (i + 1) * ringVertexCount + j + 1;
+
+			meshData.m_indices32[k++] = i * ringVertexCount + j;
+			meshData.m_indices32[k++] = (i + 1) * ringVertexCount + j + 1;
+			meshData.m_indices32[k++] = i * ringVertexCount + j + 1;
+		}
+	}
+
+	BuildCylinderTopCap(topRadius, height, sliceCount, cosTheta, sinTheta, meshData);
+	BuildCylinderBottomCap(bottomRadius, height, sliceCount, cosTheta, sinTheta, meshData);
+
+	float maxRadius = std::max(bottomRadius, topRadius);
+	float halfHeight = 0.5f * height;
+	meshData.m_boundingBox = DirectX::BoundingBox(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(maxRadius, halfHeight, maxRadius));
+	meshData.m_boundingSphere = DirectX::BoundingSphere(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), sqrtf(maxRadius * maxRadius + halfHeight * halfHeight));
+
+	return meshData;
+}
+
+GeometryGenerator::TessellatedMesh GeometryGenerator::CreateSphere(float radius, const TessellationTarget& target)
+{
+	float relativeError = std::min(TargetChordalError(target) / radius, 1.0f);
+
+	// A triangle's error grows with its circumradius, which is about half the diagonal of
+	// its quad.  Quads with equal angular sides have the shortest diagonal for their area,
+	// so start from the square quads whose diagonal meets the error and refine from there.
+	float maxAngle = acosf(1.0f - relativeError);
+	float maxStep = std::max(DirectX::XM_PI / s_maxTargetStacks, 1.41421356f * maxAngle);
+
+	uint32 stackCount = std::min(std::max((uint32)ceilf(DirectX::XM_PI / maxStep), 2u), s_maxTargetStacks);
+	uint32 sliceCount = std::min(std::max((uint32)ceilf(DirectX::XM_2PI / maxStep), 3u), s_maxTargetSlices);
+
+	while (stackCount < s_maxTargetStacks && SphereChordalError(sliceCount, stackCount) > relativeError)
+	{
+		stackCount += 1;
+		sliceCount = std::min(sliceCount + 2, s_maxTargetSlices);
+	}
+
+	// The poles make the best shape a little wider than square, so try fewer stacks with
+	// the fewest slices that still meet the error.
+	if (SphereChordalError(sliceCount, stackCount) <= relativeError)
+	{
+		uint32 firstStacks = std::max(stackCount * 2 / 3, 2u);
+		uint32 lastStacks = stackCount;
+
+		for (uint32 stacks = firstStacks; stacks < lastStacks; ++stacks)
+		{
+			uint32 lo = 3;
+			uint32 hi = std::min(2 * sliceCount, s_maxTargetSlices);
+			if (SphereChordalError(hi, stacks) > relativeError)
+				continue;
+
+			while (lo < hi)
+			{
+				uint32 mid = (lo + hi) / 2;
+				if (SphereChordalError(mid, stacks) <= relativeError)
+					hi = mid;
+				else
+					lo = mid + 1;
+			}
+
+			if (hi * (stacks - 1) < sliceCount * (stackCount - 1))
+			{
+				sliceCount = hi;
+				stackCount = stacks;
+			}
+		}
+	}
+
+	// Over budget, keep the quads square and shrink them to fit.  The sphere has
+	// 2 * slices * (stacks - 1) triangles.
+	uint32 budget = target.m_triangleBudget;
+	if (budget > 0 && 2 * sliceCount * (stackCount - 1) > budget)
+	{
+		stackCount = std::min(std::max((uint32)((1.0f + sqrtf(1.0f + (float)budget)) / 2.0f), 2u), stackCount);
+		sliceCount = std::min(std::max(budget / (2 * (stackCount - 1)), 3u), sliceCount);
+	}
+
+	TessellatedMesh result{ CreateSphere(radius, sliceCount, stackCount) };
+	result.m_chordalError = radius * SphereChordalError(sliceCount, stackCount);
+	result.m_screenError = result.m_chordalError * target.m_pixelsPerUnit;
+	result.m_sliceCount = sliceCount;
+	result.m_stackCount = stackCount;
+
+	return result;
+}
+
+GeometryGenerator::TessellatedMesh GeometryGenerator::CreateGeosphere(float radius, const TessellationTarget& target)
+{
+	float relativeError = TargetChordalError(target) / radius;
+
+	// Each level has four times the triangles of the one before, so take the first level
+	// that meets the error, or the last that fits the budget.
+	uint32 numSubdivisions = 0;
+	float error = 0.0f;
+
+	for (uint32 level = 0; level <= s_maxGeosphereSubdivisions; ++level)
+	{
+		if (level > 0 && target.m_triangleBudget > 0 && GeosphereIndexCount(level) / 3 > target.m_triangleBudget)
+			break;
+
+		const GeosphereTopology& unit = FindGeosphereTopology(level,
+			[this, level]() { return BuildUnitGeosphere(level); });
+
+		numSubdivisions = level;
+		error = GeosphereChordalError(unit);
+
+		if (error <= relativeError)
+			break;
+	}
+
+	TessellatedMesh result{ CreateGeosphere(radius, numSubdivisions) };
+	result.m_chordalError = radius * error;
+	result.m_screenError = result.m_chordalError * target.m_pixelsPerUnit;
+	result.m_numSubdivisions = numSubdivisions;
+
+	return result;
+}
+
+GeometryGenerator::TessellatedMesh GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height,
+	const TessellationTarget& target)
+{
+	// The sides are ruled, so only the slices add accuracy: the error is the sagitta of a
+	// slice's chord on the wider ring.  One stack then gives 4 * slices triangles.
+	float maxRadius = std::max(bottomRadius, topRadius);
+	float relativeError = std::min(TargetChordalError(target) / maxRadius, 1.0f);
+
+	float maxAngle = std::max(acosf(1.0f - relativeError), DirectX::XM_PI / s_maxTargetSlices);
+	uint32 sliceCount = std::min(std::max((uint32)ceilf(DirectX::XM_PI / maxAngle), 3u), s_maxTargetSlices);
+
+	if (target.m_triangleBudget > 0)
+		sliceCount = std::min(std::max(target.m_triangleBudget / 4, 3u), sliceCount);
+
+	TessellatedMesh result{ CreateCylinder(bottomRadius, topRadius, height, sliceCount, 1) };
+	result.m_chordalError = maxRadius * (1.0f - cosf(DirectX::XM_PI / sliceCount));
+	result.m_screenError = result.m_chordalError * target.m_pixelsPerUnit;
+	result.m_sliceCount = sliceCount;
+	result.m_stackCount = 1;
+
+	return result;
+}
+
+GeometryGenerator::MeshData GeometryGenerator::CreateQuad(float x, float y, float w, float h, float depth)
+{
+	MeshData meshData(m_resource);
+
+	// Position coordinates specified in NDC space.  Place the unit quad's corners at the
+	// requested rectangle.
+	meshData.m_vertices.assign(std::begin(GeometryTables::s_unitQuadVertices), std::end(GeometryTables::s_unitQuadVertices));
+	meshData.m_indices32.assign(std::begin(GeometryTables::s_quadIndices), std::end(GeometryTables::s_quadIndices));
+
+	if (x != 0.0f || y != 0.0f || w != 1.0f || h != 1.0f || depth != 0.0f)
+	{
+		for (Vertex& v : meshData.m_vertices)
+		{
+			v.m_position.x = x + v.m_position.x * w;
+			v.m_position.y = y + v.m_position.y * h;
+			v.m_position.z = depth;
+		}
+	}
+
+	DirectX::XMFLOAT3 center(x + 0.5f * w, y - 0.5f * h, depth);
+	meshData.m_boundingBox = DirectX::BoundingBox(center, DirectX::XMFLOAT3(0.5f * w, 0.5f * h, 0.0f));
+	meshData.m_boundingSphere = DirectX::BoundingSphere(center, 0.5f * sqrtf(w * w + h * h));
+
+	return meshData;
+}
+
+std::pmr::vector<GeometryGenerator::MeshData> GeometryGenerator::BuildLodChain(const MeshData& meshData, const std::vector<float>& targets)
+{
+	uint32 vertexCount = (uint32)meshData.m_vertices.size();
+	uint32 numTris = (uint32)meshData.m_indices32.size() / 3;
+
+	//
+	// Simplify each level from the previous one so that the vertices used by a level
+	// are always a subset of the ones used by the level before it.
+	//
+
+	std::pmr::vector<std::pmr::vector<uint32>> lodIndices(targets.size() + 1, m_resource);
+	lodIndices[0].assign(meshData.m_indices32.begin(), meshData.m_indices32.end());
+
+	for (size_t i = 0; i < targets.size(); ++i)
+	{
+		float fraction = std::min(std::max(targets[i], 0.0f), 1.0f);
+		uint32 targetTris = (uint32)(fraction * numTris);
+
+		lodIndices[i + 1] = lodIndices[i];
+		SimplifyIndices(meshData, lodIndices[i + 1], targetTris);
+	}
+
+	//
+	// Order the vertices coarsest level first, each group in first-use order, so the
+	// vertices of any level form a prefix of the vertex list.
+	//
+
+	const uint32 unassigned = 0xffffffff;
+	std::pmr::vector<uint32> remap(vertexCount, unassigned, m_resource);
+	std::pmr::vector<uint32> prefixCount(lodIndices.size(), 0, m_resource);
+
+	uint32 nextVertex = 0;
+	for (size_t level = lodIndices.size(); level-- > 0;)
+	{
+		for (uint32 index : lodIndices[level])
+		{
+			if (remap[index] == unassigned)
+				remap[index] = nextVertex++;
+		}
+
+		prefixCount[level] = nextVertex;
+	}
+
+	for (uint32 v = 0; v < vertexCount; ++v)
+	{
+		if (remap[v] == unassigned)
+			remap[v] = nextVertex++;
+	}
+
+	std::pmr::vector<MeshData> chain(m_resource);
+	chain.reserve(lodIndices.size());
+	for (size_t level = 0; level < lodIndices.size(); ++level)
+		chain.emplace_back(m_resource);
+
+	chain[0].m_vertices.resize(vertexCount);
+	for (uint32 v = 0; v < vertexCount; ++v)
+		chain[0].m_vertices[remap[v]] = meshData.m_vertices[v];
+
+	for (size_t level = 0; level < chain.size(); ++level)
+	{
+		MeshData& lod = chain[level];
+
+		if (level > 0)
+			lod.m_vertices.assign(chain[0].m_vertices.begin(), chain[0].m_vertices.begin() + prefixCount[level]);
+
+		lod.m_indices32.resize(lodIndices[level].size());
+		for (size_t k = 0; k < lodIndices[level].size(); ++k)
+			lod.m_indices32[k] = remap[lodIndices[level][k]];
+
+		// Simplification never moves a vertex, so the source bounds still hold.
+		lod.m_boundingBox = meshData.m_boundingBox;
+		lod.m_boundingSphere = meshData.m_boundingSphere;
+	}
+
+	return chain;
+}
+
+void GeometryGenerator::SimplifyIndices(const MeshData& meshData, std::pmr::vector<uint32>& indices, uint32 targetTriangleCount)
+{
+	uint32 vertexCount = (uint32)meshData.m_vertices.size();
+
+	//
+	// Lock vertices on edges that are not shared by exactly two triangles.  These are
+	// the open borders of the mesh and the seams where vertices are duplicated for
+	// texture coordinates or normals, and collapsing them would open cracks.
+	//
+
+	std::pmr::vector<std::uint64_t> edges(indices.size(), m_resource);
+	for (size_t t = 0; t < indices.size(); t += 3)
+	{
+		edges[t + 0] = EdgeKey(indices[t + 0], indices[t + 1]);
+		edges[t + 1] = EdgeKey(indices[t + 1], indices[t + 2]);
+		edges[t + 2] = EdgeKey(indices[t + 2], indices[t + 0]);
+	}
+	std::sort(edges.begin(), edges.end());
+
+	std::pmr::vector<bool> locked(vertexCount, false, m_resource);
+	for (size_t e = 0; e < edges.size();)
+	{
+		size_t run = e + 1;
+		while (run < edges.size() && edges[run] == edges[e])
+			++run;
+
+		if (run - e != 2)
+		{
+			locked[(uint32)(edges[e] >> 32)] = true;
+			locked[(uint32)edges[e]] = true;
+		}
+
+		e = run;
+	}
+
+	//
+	// Accumulate the area weighted plane quadric of every triangle into its vertices.
+	//
+
+	std::pmr::vector<Quadric> quadrics(vertexCount, m_resource);
+	for (size_t t = 0; t < indices.size(); t += 3)
+	{
+		const DirectX::XMFLOAT3& p0 = meshData.m_vertices[indices[t + 0]].m_position;
+
+		DirectX::XMVECTOR n = TriangleNormal(p0,
+			meshData.m_vertices[indices[t + 1]].m_position,
+			meshData.m_vertices[indices[t + 2]].m_position);
+
+		float length = DirectX::XMVectorGetX(DirectX::XMVector3Length(n));
+		if (length <= 0.0f)
+			continue;
+
+		DirectX::XMFLOAT3 unitNormal;
+		DirectX::XMStoreFloat3(&unitNormal, DirectX::XMVectorScale(n, 1.0f / length));
+
+		double d = -(unitNormal.x * p0.x + unitNormal.y * p0.y + unitNormal.z * p0.z);
+
+		for (uint32 k = 0; k < 3; ++k)
+			quadrics[indices[t + k]].AddPlane(unitNormal.x, unitNormal.y, unitNormal.z, d, 0.5 * length);
+	}
+
+	//
+	// Collapse edges in passes.  Each pass ranks every collapsible edge by the error of
+	// moving one end onto the other, then collapses them cheapest first, touching each
+	// vertex at most once so the costs computed for the pass stay valid.
+	//
+
+	struct Collapse
+	{
+		double m_cost;
+		uint32 m_from;
+		uint32 m_to;
+	};
+
+	// The index list only shrinks, so every array is sized once and reused by each pass
+	// rather than left behind in a monotonic resource.
+	std::pmr::vector<Collapse> collapses(m_resource);
+	std::pmr::vector<uint32> collapseTo(vertexCount, m_resource);
+	std::pmr::vector<bool> touched(vertexCount, false, m_resource);
+	std::pmr::vector<uint32> adjOffset(vertexCount + 1, m_resource);
+	std::pmr::vector<uint32> adjTris(indices.size(), m_resource);
+	std::pmr::vector<uint32> adjFill(vertexCount, m_resource);
+	collapses.reserve(indices.size());
+
+	uint32 triCount = (uint32)indices.size() / 3;
+
+	while (triCount > targetTriangleCount)
+	{
+		// Vertex to triangle adjacency of the current index list.
+		std::fill(adjOffset.begin(), adjOffset.end(), 0);
+		for (uint32 index : indices)
+			++adjOffset[index + 1];
+		for (uint32 v = 0; v < vertexCount; ++v)
+			adjOffset[v + 1] += adjOffset[v];
+
+		std::copy(adjOffset.begin(), adjOffset.end() - 1, adjFill.begin());
+		for (uint32 t = 0; t < triCount; ++t)
+		{
+			for (uint32 k = 0; k < 3; ++k)
+				adjTris[adjFill[indices[t * 3 + k]]++] = t;
+		}
+
+		// Rank the unique edges.
+		edges.resize(indices.size());
+		for (size_t t = 0; t < indices.size(); t += 3)
+		{
+			edges[t + 0] = EdgeKey(indices[t + 0], indices[t + 1]);
+			edges[t + 1] = EdgeKey(indices[t + 1], indices[t + 2]);
+			edges[t + 2] = EdgeKey(indices[t + 2], indices[t + 0]);
+		}
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		collapses.clear();
+		for (std::uint64_t edge : edges)
+		{
+			uint32 a = (uint32)(edge >> 32);
+			uint32 b = (uint32)edge;
+
+			Quadric q = quadrics[a];
+			q.Add(quadrics[b]);
+
+			Collapse best = { -1.0, a, b };
+			if (!locked[a])
+				best = { q.Error(meshData.m_vertices[b].m_position), a, b };
+
+			if (!locked[b])
+			{
+				double cost = q.Error(meshData.m_vertices[a].m_position);
+				if (best.m_cost < 0.0 || cost < best.m_cost)
+					best = { cost, b, a };
+			}
+
+			if (best.m_cost >= 0.0)
+				collapses.push_back(best);
+		}
+
+		std::sort(collapses.begin(), collapses.end(),
+			[](const Collapse& c0, const Collapse& c1) { return c0.m_cost < c1.m_cost; });
+
+		for (uint32 v = 0; v < vertexCount; ++v)
+			collapseTo[v] = v;
+		std::fill(touched.begin(), touched.end(), false);
+
+		uint32 collapsed = 0;
+		for (const Collapse& c : collapses)
+		{
+			if (triCount <= targetTriangleCount)
+				break;
+
+			if (touched[c.m_from] || touched[c.m_to])
+				continue;
+
+			// Reject the collapse if it would flip any surviving triangle around from.
+			bool flips = false;
+			uint32 removed = 0;
+			for (uint32 a = adjOffset[c.m_from]; a < adjOffset[c.m_from + 1] && !flips; ++a)
+			{
+				const uint32* tri = &indices[adjTris[a] * 3];
+
+				uint32 before[3];
+				uint32 after[3];
+				for (uint32 k = 0; k < 3; ++k)
+				{
+					before[k] = collapseTo[tri[k]];
+					after[k] = before[k] == c.m_from ? c.m_to : before[k];
+				}
+
+				if (after[0] == after[1] || after[1] == after[2] || after[0] == after[2])
+				{
+					++removed;
+					continue;
+				}
+
+				DirectX::XMVECTOR n0 = TriangleNormal(meshData.m_vertices[before[0]].m_position,
+					meshData.m_vertices[before[1]].m_position, meshData.m_vertices[before[2]].m_position);
+				DirectX::XMVECTOR n1 = TriangleNormal(meshData.m_vertices[after[0]].m_position,
+					meshData.m_vertices[after[1]].m_position, meshData.m_vertices[after[2]].m_position);
+
+				// Also reject large rotations, which fold slivers over their neighbours
+				// as the passes accumulate.
+				float cosAngle = DirectX::XMVectorGetX(DirectX::XMVector3Dot(n0, n1));
+				float lengths = DirectX::XMVectorGetX(DirectX::XMVector3Length(n0)) *
+					DirectX::XMVectorGetX(DirectX::XMVector3Length(n1));
+
+				flips = cosAngle <= 0.25f * lengths;
+			}
+
+			if (flips)
+				continue;
+
+			collapseTo[c.m_from] = c.m_to;
+			quadrics[c.m_to].Add(quadrics[c.m_from]);
+			touched[c.m_from] = true;
+			touched[c.m_to] = true;
+
+			triCount -= std::min(removed, triCount);
+			++collapsed;
+		}
+
+		// Nothing left that can be collapsed without breaking the mesh.
+		if (collapsed == 0)
+			break;
+
+		// Apply the pass and drop the triangles that became degenerate.
+		size_t out = 0;
+		for (size_t t = 0; t < indices.size(); t += 3)
+		{
+			uint32 i0 = collapseTo[indices[t + 0]];
+			uint32 i1 = collapseTo[indices[t + 1]];
+			uint32 i2 = collapseTo[indices[t + 2]];
+
+			if (i0 == i1 || i1 == i2 || i0 == i2)
+				continue;
+
+			indices[out++] = i0;
+			indices[out++] = i1;
+			indices[out++] = i2;
+		}
+
+		indices.resize(out);
+		triCount = (uint32)out / 3;
+	}
+}
+
+GeometryGenerator::MeshletData GeometryGenerator::BuildMeshlets(const MeshData& meshData, uint32 maxVertices, uint32 maxPrimitives)
+{
+	MeshletData meshletData;
+
+	// Local indices are stored in a byte.
+	maxVertices = std::min(std::max(maxVertices, 3u), 256u);
+	maxPrimitives = std::max(maxPrimitives, 1u);
+
+	uint32 vertexCount = (uint32)meshData.m_vertices.size();
+	uint32 numTris = (uint32)meshData.m_indices32.size() / 3;
+
+	meshletData.m_primitiveIndices.reserve(numTris * 3);
+	meshletData.m_vertexIndices.reserve(vertexCount + vertexCount / 2);
+
+	const uint32 unassigned = 0xffffffff;
+	std::pmr::vector<uint32> owner(vertexCount, unassigned, m_resource);
+	std::pmr::vector<std::uint8_t> localIndex(vertexCount, 0, m_resource);
+
+	Meshlet current;
+	std::pmr::vector<DirectX::XMVECTOR> normals(m_resource);
+	normals.reserve(maxPrimitives);
+
+	auto finishMeshlet = [&]()
+	{
+		if (current.m_primitiveCount == 0)
+			return;
+
+		const uint32* vertices = &meshletData.m_vertexIndices[current.m_vertexOffset];
+		const std::uint8_t* prims = &meshletData.m_primitiveIndices[current.m_primitiveOffset * 3];
+
+		auto position = [&](uint32 i) { return DirectX::XMLoadFloat3(&meshData.m_vertices[vertices[i]].m_position); };
+
+		DirectX::BoundingBox box;
+		DirectX::BoundingSphere sphere;
+		ComputePointBounds(current.m_vertexCount, position, box, sphere);
+
+		current.m_center = sphere.Center;
+		current.m_radius = sphere.Radius;
+
+		//
+		// Normal cone.  The axis is the average triangle normal and the cutoff comes
+		// from the triangle that deviates most from it.
+		//
+
+		normals.resize(current.m_primitiveCount);
+		DirectX::XMVECTOR axis = DirectX::XMVectorZero();
+		for (uint32 t = 0; t < current.m_primitiveCount; ++t)
+		{
+			DirectX::XMVECTOR p0 = position(prims[t * 3 + 0]);
+			DirectX::XMVECTOR e0 = DirectX::XMVectorSubtract(position(prims[t * 3 + 1]), p0);
+			DirectX::XMVECTOR e1 = DirectX::XMVectorSubtract(position(prims[t * 3 + 2]), p0);
+
+			normals[t] = DirectX::XMVector3Normalize(DirectX::XMVector3Cross(e0, e1));
+			axis = DirectX::XMVectorAdd(axis, normals[t]);
+		}
+
+		axis = DirectX::XMVector3Normalize(axis);
+
+		float minDot = 1.0f;
+		for (const DirectX::XMVECTOR& n : normals)
+			minDot = std::min(minDot, DirectX::XMVectorGetX(DirectX::XMVector3Dot(n, axis)));
+
+		DirectX::XMStoreFloat3(&current.m_coneAxis, axis);
+		current.m_coneApex = current.m_center;
+
+		// A cone wider than a hemisphere can never be culled.
+		if (minDot <= 0.0f)
+		{
+			current.m_coneCutoff = 2.0f;
+		}
+		else
+		{
+			// Pull the apex back along the axis until it is behind every triangle
+			// plane, so the test is conservative for eyes close to the meshlet.
+			DirectX::XMVECTOR center = DirectX::XMLoadFloat3(&current.m_center);
+			float maxT = 0.0f;
+			for (uint32 t = 0; t < current.m_primitiveCount; ++t)
+			{
+				DirectX::XMVECTOR toCenter = DirectX::XMVectorSubtract(center, position(prims[t * 3 + 0]));
+				float dc = DirectX::XMVectorGetX(DirectX::XMVector3Dot(toCenter, normals[t]));
+				float dn = DirectX::XMVectorGetX(DirectX::XMVector3Dot(axis, normals[t]));
+
+				maxT = std::max(maxT, dc / dn);
+			}
+
+			DirectX::XMStoreFloat3(&current.m_coneApex, DirectX::XMVectorSubtract(center, DirectX::XMVectorScale(axis, maxT)));
+			current.m_coneCutoff = sqrtf(1.0f - minDot * minDot);
+		}
+
+		meshletData.m_meshlets.push_back(current);
+
+		current = Meshlet();
+		current.m_vertexOffset = (uint32)meshletData.m_vertexIndices.size();
+		current.m_primitiveOffset = (uint32)meshletData.m_primitiveIndices.size() / 3;
+	};
+
+	for (uint32 t = 0; t < numTris; ++t)
+	{
+		const uint32* tri = &meshData.m_indices32[t * 3];
+		uint32 meshletIndex = (uint32)meshletData.m_meshlets.size();
+
+		// Count the distinct vertices of the triangle not yet in this meshlet.
+		uint32 newVertices = 0;
+		for (uint32 k = 0; k < 3; ++k)
+		{
+			if (owner[tri[k]] != meshletIndex &&
+				(k == 0 || tri[k] != tri[0]) && (k < 2 || tri[k] != tri[1]))
+				++newVertices;
+		}
+
+		if (current.m_vertexCount + newVertices > maxVertices || current.m_primitiveCount == maxPrimitives)
+		{
+			finishMeshlet();
+			meshletIndex = (uint32)meshletData.m_meshlets.size();
+		}
+
+		for (uint32 k = 0; k < 3; ++k)
+		{
+			uint32 v = tri[k];
+			if (owner[v] != meshletIndex)
+			{
+				owner[v] = meshletIndex;
+				localIndex[v] = (std::uint8_t)current.m_vertexCount++;
+				meshletData.m_vertexIndices.push_back(v);
+			}
+
+			meshletData.m_primitiveIndices.push_back(localIndex[v]);
+		}
+
+		++current.m_primitiveCount;
+	}
+
+	finishMeshlet();
+
+	return meshletData;
+}
+
+void GeometryGenerator::ComputeBounds(MeshData& meshData)
+{
+	ComputePointBounds((uint32)meshData.m_vertices.size(),
+		[&meshData](uint32 i) { return DirectX::XMLoadFloat3(&meshData.m_vertices[i].m_position); },
+		meshData.m_boundingBox, meshData.m_boundingSphere);
+}
+
+void GeometryGenerator::ComputeNormalsAndTangents(MeshData& meshData)
+{
+	uint32 vertexCount = (uint32)meshData.m_vertices.size();
+	uint32 numTris = (uint32)meshData.m_indices32.size() / 3;
+
+	std::pmr::vector<Vertex>& vertices = meshData.m_vertices;
+	const std::pmr::vector<uint32>& indices = meshData.m_indices32;
+
+	//
+	// Per triangle: the normal scaled by twice the area, and the unit direction of
+	// increasing u (dP/du) scaled the same way so both sums are area weighted.
+	//
+
+	std::pmr::vector<DirectX::XMFLOAT3> faceNormals(numTris, m_resource);
+	std::pmr::vector<DirectX::XMFLOAT3> faceTangents(numTris, m_resource);
+
+	ParallelFor(numTris, s_minVerticesPerTask, [&](uint32 begin, uint32 end)
+	{
+		for (uint32 t = begin; t < end; ++t)
+		{
+			const Vertex& v0 = vertices[indices[t * 3 + 0]];
+			const Vertex& v1 = vertices[indices[t * 3 + 1]];
+			const Vertex& v2 = vertices[indices[t * 3 + 2]];
+
+			DirectX::XMVECTOR normal = TriangleNormal(v0.m_position, v1.m_position, v2.m_position);
+			DirectX::XMStoreFloat3(&faceNormals[t], normal);
+
+			DirectX::XMVECTOR p0 = DirectX::XMLoadFloat3(&v0.m_position);
+			DirectX::XMVECTOR e0 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&v1.m_position), p0);
+			DirectX::XMVECTOR e1 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&v2.m_position), p0);
+
+			float du0 = v1.m_texC.x - v0.m_texC.x;
+			float dv0 = v1.m_texC.y - v0.m_texC.y;
+			float du1 = v2.m_texC.x - v0.m_texC.x;
+			float dv1 = v2.m_texC.y - v0.m_texC.y;
+
+			// Solve e0 = du0 T + dv0 B, e1 = du1 T + dv1 B for T.  Only its direction is
+			// kept, so the determinant's magnitude does not matter, only its sign.
+			float det = du0 * dv1 - du1 * dv0;
+			float doubleArea = DirectX::XMVectorGetX(DirectX::XMVector3Length(normal));
+
+			DirectX::XMVECTOR tangent = DirectX::XMVectorZero();
+			if (det != 0.0f)
+			{
+				tangent = DirectX::XMVectorSubtract(DirectX::XMVectorScale(e0, dv1), DirectX::XMVectorScale(e1, dv0));
+				tangent = DirectX::XMVectorScale(DirectX::XMVector3Normalize(tangent), det > 0.0f ? doubleArea : -doubleArea);
+			}
+
+			DirectX::XMStoreFloat3(&faceTangents[t], tangent);
+		}
+	});
+
+	//
+	// Vertex to triangle adjacency in compressed rows, built without locks: count and
+	// fill with atomic increments, then sort each row so the sums below are taken in
+	// the same order however the fill was scheduled.
+	//
+
+	std::pmr::vector<std::atomic<uint32>> adjCursor(vertexCount, m_resource);
+	ParallelFor(numTris * 3, s_minVerticesPerTask, [&](uint32 begin, uint32 end)
+	{
+		for (uint32 i = begin; i < end; ++i)
+			adjCursor[indices[i]].fetch_add(1, std::memory_order_relaxed);
+	});
+
+	std::pmr::vector<uint32> adjOffset(vertexCount + 1, 0, m_resource);
+	for (uint32 v = 0; v < vertexCount; ++v)
+	{
+		adjOffset[v + 1] = adjOffset[v] + adjCursor[v].load(std::memory_order_relaxed);
+		adjCursor[v].store(adjOffset[v], std::memory_order_relaxed);
+	}
+
+	std::pmr::vector<uint32> adjTris(numTris * 3, m_resource);
+	ParallelFor(numTris * 3, s_minVerticesPerTask, [&](uint32 begin, uint32 end)
+	{
+		for (uint32 i = begin; i < end; ++i)
+			adjTris[adjCursor[indices[i]].fetch_add(1, std::memory_order_relaxed)] = i / 3;
+	});
+
+	//
+	// Per vertex: gather the faces around it, which only writes the vertex itself.
+	//
+
+	ParallelFor(vertexCount, s_minVerticesPerTask, [&](uint32 begin, uint32 end)
+	{
+		for (uint32 v = begin; v < end; ++v)
+		{
+			uint32* first = adjTris.data() + adjOffset[v];
+			uint32* last = adjTris.data() + adjOffset[v + 1];
+			std::sort(first, last);
+
+			DirectX::XMVECTOR normal = DirectX::XMVectorZero();
+			DirectX::XMVECTOR tangent = DirectX::XMVectorZero();
+			for (const uint32* t = first; t != last; ++t)
+			{
+				normal = DirectX::XMVectorAdd(normal, DirectX::XMLoadFloat3(&faceNormals[*t]));
+				tangent = DirectX::XMVectorAdd(tangent, DirectX::XMLoadFloat3(&faceTangents[*t]));
+			}
+
+			Vertex& vertex = vertices[v];
+
+			if (DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(normal)) > 0.0f)
+			{
+				normal = DirectX::XMVector3Normalize(normal);
+				DirectX::XMStoreFloat3(&vertex.m_normal, normal);
+			}
+			else
+			{
+				normal = DirectX::XMLoadFloat3(&vertex.m_normal);
+			}
+
+			// Gram-Schmidt: remove the part of the tangent along the normal.
+			tangent = DirectX::XMVectorSubtract(tangent,
+				DirectX::XMVectorMultiply(normal, DirectX::XMVector3Dot(normal, tangent)));
+
+			float tangentLengthSq = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(tangent));
+			tangent = tangentLengthSq > FLT_MIN ? DirectX::XMVector3Normalize(tangent) : AnyPerpendicular(normal);
+
+			DirectX::XMStoreFloat3(&vertex.m_tangentU, tangent);
+		}
+	});
 }
 
-GeometryGenerator::Vertex::Vertex(const DirectX::XMFLOAT3& pos, const DirectX::XMFLOAT3& norm, const DirectX::XMFLOAT3& tang, const DirectX::XMFLOAT2& uv)
-	: m_position(pos),
-	m_normal(norm),
-	m_tangentU(tang),
-	m_texC(uv)
+void GeometryGenerator::WriteVertices(const MeshData& meshData, const VertexLayout& layout, void* dest)
 {
+	std::uint8_t* out = static_cast<std::uint8_t*>(dest);
+
+	// Write each vertex in one go so the destination is filled sequentially, which is
+	// what write-combined upload heaps want.
+	for (const Vertex& v : meshData.m_vertices)
+	{
+		if (layout.m_positionOffset >= 0)
+			std::memcpy(out + layout.m_positionOffset, &v.m_position, sizeof(v.m_position));
+
+		if (layout.m_normalOffset >= 0)
+			std::memcpy(out + layout.m_normalOffset, &v.m_normal, sizeof(v.m_normal));
+
+		if (layout.m_tangentUOffset >= 0)
+			std::memcpy(out + layout.m_tangentUOffset, &v.m_tangentU, sizeof(v.m_tangentU));
+
+		if (layout.m_texCOffset >= 0)
+			std::memcpy(out + layout.m_texCOffset, &v.m_texC, sizeof(v.m_texC));
+
+		if (layout.m_colorOffset >= 0)
+			std::memcpy(out + layout.m_colorOffset, &layout.m_color, sizeof(layout.m_color));
+
+		out += layout.m_stride;
+	}
 }
 
-GeometryGenerator::Vertex::Vertex(float px, float py, float pz, float nx, float ny, float nz, float tx, float ty, float tz, float u, float v)
-	: m_position(px, py, pz),
-	m_normal(nx, ny, nz),
-	m_tangentU(tx, ty, tz),
-	m_texC(u,v)
+GeometryGenerator::PackedMeshData GeometryGenerator::PackVertices(const MeshData& meshData)
 {
+	PackedMeshData packedData;
+
+	uint32 vertexCount = (uint32)meshData.m_vertices.size();
+	packedData.m_vertices.resize(vertexCount);
+
+	// Quantize against the exact bounds of the positions, rather than the stored ones,
+	// so stale or conservative bounds cannot waste precision or clip a vertex.
+	DirectX::BoundingBox box;
+	DirectX::BoundingSphere sphere;
+	ComputePointBounds(vertexCount,
+		[&meshData](uint32 i) { return DirectX::XMLoadFloat3(&meshData.m_vertices[i].m_position); },
+		box, sphere);
+
+	DirectX::XMVECTOR center = DirectX::XMLoadFloat3(&box.Center);
+	DirectX::XMVECTOR extents = DirectX::XMLoadFloat3(&box.Extents);
+	DirectX::XMVECTOR bias = DirectX::XMVectorSubtract(center, extents);
+	DirectX::XMVECTOR scale = DirectX::XMVectorAdd(extents, extents);
+
+	// Flat axes (a grid has no height) map to zero instead of dividing by zero.
+	DirectX::XMVECTOR invScale = DirectX::XMVectorSelect(DirectX::XMVectorZero(), DirectX::XMVectorReciprocal(scale),
+		DirectX::XMVectorGreater(scale, DirectX::XMVectorZero()));
+
+	DirectX::XMStoreFloat3(&packedData.m_positionScale, scale);
+	DirectX::XMStoreFloat3(&packedData.m_positionBias, bias);
+
+	ParallelFor(vertexCount, s_minVerticesPerTask, [&](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; ++i)
+			{
+				const Vertex& v = meshData.m_vertices[i];
+				PackedVertex& packed = packedData.m_vertices[i];
+
+				DirectX::XMVECTOR position = DirectX::XMVectorMultiply(
+					DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&v.m_position), bias), invScale);
+
+				DirectX::PackedVector::XMStoreUShortN4(&packed.m_position, position);
+				DirectX::PackedVector::XMStoreShortN2(&packed.m_normal, OctahedralEncode(DirectX::XMLoadFloat3(&v.m_normal)));
+				DirectX::PackedVector::XMStoreShortN2(&packed.m_tangentU, OctahedralEncode(DirectX::XMLoadFloat3(&v.m_tangentU)));
+				DirectX::PackedVector::XMStoreHalf2(&packed.m_texC, DirectX::XMLoadFloat2(&v.m_texC));
+			}
+		});
+
+	return packedData;
 }
 
-std::vector<uint16>& GeometryGenerator::MeshData::GetIndices16()
+void GeometryGenerator::UnpackVertices(const PackedMeshData& packedData, std::vector<Vertex>& vertices)
 {
-	if (m_indices16.empty())
+	uint32 vertexCount = (uint32)packedData.m_vertices.size();
+	vertices.resize(vertexCount);
+
+	DirectX::XMVECTOR scale = DirectX::XMLoadFloat3(&packedData.m_positionScale);
+	DirectX::XMVECTOR bias = DirectX::XMLoadFloat3(&packedData.m_positionBias);
+
+	ParallelFor(vertexCount, s_minVerticesPerTask, [&](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; ++i)
+			{
+				const PackedVertex& packed = packedData.m_vertices[i];
+				Vertex& v = vertices[i];
+
+				DirectX::XMVECTOR position = DirectX::XMVectorMultiplyAdd(
+					DirectX::PackedVector::XMLoadUShortN4(&packed.m_position), scale, bias);
+
+				DirectX::XMStoreFloat3(&v.m_position, position);
+				DirectX::XMStoreFloat3(&v.m_normal, OctahedralDecode(DirectX::PackedVector::XMLoadShortN2(&packed.m_normal)));
+				DirectX::XMStoreFloat3(&v.m_tangentU, OctahedralDecode(DirectX::PackedVector::XMLoadShortN2(&packed.m_tangentU)));
+				DirectX::XMStoreFloat2(&v.m_texC, DirectX::PackedVector::XMLoadHalf2(&packed.m_texC));
+			}
+		});
+}
+
+GeometryGenerator::PackingError GeometryGenerator::MeasurePackingError(const MeshData& meshData, const PackedMeshData& packedData)
+{
+	assert(meshData.m_vertices.size() == packedData.m_vertices.size());
+
+	std::vector<Vertex> unpacked;
+	UnpackVertices(packedData, unpacked);
+
+	PackingError error;
+	for (size_t i = 0; i < unpacked.size(); ++i)
 	{
-		m_indices16.resize(m_indices32.size());
-		for (size_t i = 0; i < m_indices32.size(); ++i)
-			m_indices16[i] = static_cast<uint16>(m_indices32[i]);
+		const Vertex& original = meshData.m_vertices[i];
+		const Vertex& v = unpacked[i];
+
+		DirectX::XMVECTOR dp = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&v.m_position), DirectX::XMLoadFloat3(&original.m_position));
+		DirectX::XMVECTOR dt = DirectX::XMVectorSubtract(DirectX::XMLoadFloat2(&v.m_texC), DirectX::XMLoadFloat2(&original.m_texC));
+
+		error.m_maxPositionError = std::max(error.m_maxPositionError, DirectX::XMVectorGetX(DirectX::XMVector3Length(dp)));
+		error.m_maxNormalError = std::max(error.m_maxNormalError, DirectionError(original.m_normal, DirectX::XMLoadFloat3(&v.m_normal)));
+		error.m_maxTangentError = std::max(error.m_maxTangentError, DirectionError(original.m_tangentU, DirectX::XMLoadFloat3(&v.m_tangentU)));
+		error.m_maxTexCError = std::max(error.m_maxTexCError, DirectX::XMVectorGetX(DirectX::XMVector2Length(dt)));
 	}
 
-	return m_indices16;
+	return error;
 }
 
-GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float depth, uint32 m, uint32 n)
+uint32 GeometryGenerator::Weld(MeshData& meshData, float epsilon, uint32 attributeMask)
 {
-	MeshData meshData;
+	uint32 vertexCount = (uint32)meshData.m_vertices.size();
+	if (vertexCount == 0)
+		return 0;
 
-	uint32 vertexCount = m * n;
-	uint32 faceCount = (m - 1) * (n - 1) * 2;
+	epsilon = std::max(epsilon, 0.0f);
+
+	// Cells four times the tolerance wide, so the neighbourhood of a point spans at most
+	// two cells per axis and usually one.  Wider cells only lengthen the chains.
+	float invCellSize = epsilon > 0.0f ? 0.25f / epsilon : 0.0f;
+
+	auto matches = [epsilon, attributeMask](const Vertex& a, const Vertex& b)
+	{
+		return WithinTolerance(&a.m_position.x, &b.m_position.x, 3, epsilon)
+			&& (!(attributeMask & WeldNormal) || WithinTolerance(&a.m_normal.x, &b.m_normal.x, 3, epsilon))
+			&& (!(attributeMask & WeldTangentU) || WithinTolerance(&a.m_tangentU.x, &b.m_tangentU.x, 3, epsilon))
+			&& (!(attributeMask & WeldTexC) || WithinTolerance(&a.m_texC.x, &b.m_texC.x, 2, epsilon));
+	};
 
 	//
-	// Create the vertices.
+	// The kept vertices are compacted to the front of the array as they are found, so
+	// the hash only has to store their new indices.  Each slot of the open addressed
+	// table holds the last vertex kept in one cell and the rest of the cell's vertices
+	// are chained through nextInCell.
 	//
 
-	float halfWidth = 0.5f * width;
-	float halfDepth = 0.5f * depth;
+	std::pmr::vector<Vertex>& vertices = meshData.m_vertices;
 
-	float dx = width / (n - 1);
-	float dz = depth / (m - 1);
+	uint32 tableSize = 1;
+	while (tableSize < (std::uint64_t)vertexCount + vertexCount / 4)
+		tableSize <<= 1;
 
-	float du = 1.0f / (n - 1);
-	float dv = 1.0f / (m - 1);
+	const uint32 empty = 0xffffffff;
+	std::pmr::vector<WeldCellSlot> table(tableSize, WeldCellSlot{ 0, 0, 0, empty }, m_resource);
+	std::pmr::vector<uint32> nextInCell(vertexCount, empty, m_resource);
+	std::pmr::vector<uint32> remap(vertexCount, m_resource);
 
-	meshData.m_vertices.resize(vertexCount);
-	for (uint32 i = 0; i < m; ++i)
+	// On a large mesh nearly every lookup misses the cache, and the serial pass below
+	// would wait on each one in turn.  The home cell hashes do not depend on each other,
+	// so compute them up front and prefetch each vertex's slot a few vertices early.
+	std::pmr::vector<uint32> homeHash(vertexCount, m_resource);
+	ParallelFor(vertexCount, s_minVerticesPerTask, [&](uint32 begin, uint32 end)
 	{
-		float z = halfDepth - i * dz;
-		for (uint32 j = 0; j < n; ++j)
+		for (uint32 v = begin; v < end; ++v)
 		{
-			float x = -halfWidth + j * dx;
-
-			meshData.m_vertices[i * n + j].m_position = DirectX::XMFLOAT3(x, 0.0f, z);
-			meshData.m_vertices[i * n + j].m_normal = DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f);
-			meshData.m_vertices[i * n + j].m_tangentU = DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f);
-
-			// Stretch texture over grid.
-			meshData.m_vertices[i * n + j].m_texC.x = j * du;
-			meshData.m_vertices[i * n + j].m_texC.y = i * dv;
+			const DirectX::XMFLOAT3& p = vertices[v].m_position;
+			homeHash[v] = WeldCellHash(WeldCell(p.x, invCellSize), WeldCell(p.y, invCellSize), WeldCell(p.z, invCellSize));
 		}
-	}
+	});
 
-	//
-	// Create the indices.
-	//
+	// Returns the slot of a cell, or the empty slot it would go in.
+	auto findSlot = [&](std::int32_t cx, std::int32_t cy, std::int32_t cz, uint32 hash) -> WeldCellSlot&
+	{
+		uint32 slot = hash & (tableSize - 1);
+		while (table[slot].m_head != empty &&
+			(table[slot].m_x != cx || table[slot].m_y != cy || table[slot].m_z != cz))
+			slot = (slot + 1) & (tableSize - 1);
 
-	meshData.m_indices32.resize(faceCount * 3); // 3 indices per face
+		return table[slot];
+	};
 
-	// Iterate over each quad and compute indices.
-	uint32 k = 0;
-	for (uint32 i = 0; i < m - 1; ++i)
+	auto findInCell = [&](const WeldCellSlot& cell, const Vertex& vertex)
 	{
-		for (uint32 j = 0; j < n - 1; ++j)
+		for (uint32 r = cell.m_head; r != empty; r = nextInCell[r])
 		{
-			meshData.m_indices32[k] = i * n + j;
-			meshData.m_indices32[k + 1] = i * n + j + 1;
-			meshData.m_indices32[k + 2] = (i + 1) * n + j;
+			if (matches(vertices[r], vertex))
+				return r;
+		}
+
+		return empty;
+	};
+
+	uint32 keptCount = 0;
+	for (uint32 v = 0; v < vertexCount; ++v)
+	{
+		if (v + s_weldPrefetchDistance < vertexCount)
+			Prefetch(&table[homeHash[v + s_weldPrefetchDistance] & (tableSize - 1)]);
 
-			meshData.m_indices32[k + 3] = (i + 1) * n + j;
-			meshData.m_indices32[k + 4] = i * n + j + 1;
-			meshData.m_indices32[k + 5] = (i + 1) * n + j + 1;
+		const Vertex& vertex = vertices[v];
+		const float* p = &vertex.m_position.x;
 
-			k += 6; // next quad
+		std::int32_t home[3];
+		std::int32_t lo[3];
+		std::int32_t hi[3];
+		for (uint32 k = 0; k < 3; ++k)
+		{
+			home[k] = WeldCell(p[k], invCellSize);
+			lo[k] = WeldCell(p[k] - epsilon, invCellSize);
+			hi[k] = WeldCell(p[k] + epsilon, invCellSize);
 		}
-	}
 
-	return meshData;
-}
+		// The vertex's own cell is the likeliest to hold a match, so try it first and
+		// then the neighbours its tolerance reaches into.
+		WeldCellSlot& homeSlot = findSlot(home[0], home[1], home[2], homeHash[v]);
+		uint32 match = findInCell(homeSlot, vertex);
 
-GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions)
-{
-	MeshData meshData;
+		for (std::int64_t cz = lo[2]; cz <= hi[2] && match == empty; ++cz)
+		{
+			for (std::int64_t cy = lo[1]; cy <= hi[1] && match == empty; ++cy)
+			{
+				for (std::int64_t cx = lo[0]; cx <= hi[0] && match == empty; ++cx)
+				{
+					if (cx == home[0] && cy == home[1] && cz == home[2])
+						continue;
+
+					const WeldCellSlot& cell = findSlot((std::int32_t)cx, (std::int32_t)cy, (std::int32_t)cz,
+						WeldCellHash((std::int32_t)cx, (std::int32_t)cy, (std::int32_t)cz));
+					match = findInCell(cell, vertex);
+				}
+			}
+		}
 
-	//
-	// Create the vertices.
-	//
+		if (match != empty)
+		{
+			remap[v] = match;
+			continue;
+		}
 
-	Vertex v[24];
+		vertices[keptCount] = vertex;
 
-	float w2 = 0.5f * width;
-	float h2 = 0.5f * height;
-	float d2 = 0.5f * depth;
+		if (homeSlot.m_head == empty)
+			homeSlot = WeldCellSlot{ home[0], home[1], home[2], empty };
 
-	// Fill in the front face vertex data.
-	v[0] = Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[1] = Vertex(-w2, +h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[2] = Vertex(+w2, +h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[3] = Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+		nextInCell[keptCount] = homeSlot.m_head;
+		homeSlot.m_head = keptCount;
+		remap[v] = keptCount++;
+	}
 
-	// Fill in the back face vertex data.
-	v[4] = Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[5] = Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[6] = Vertex(+w2, +h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[7] = Vertex(-w2, +h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+	for (uint32& index : meshData.m_indices32)
+		index = remap[index];
 
-	// Fill in the top face vertex data.
-	v[8] = Vertex(-w2, +h2, -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[9] = Vertex(-w2, +h2, +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[10] = Vertex(+w2, +h2, +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[11] = Vertex(+w2, +h2, -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+	vertices.resize(keptCount);
+	meshData.m_indices16.clear();
 
-	// Fill in the bottom face vertex data.
-	v[12] = Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[13] = Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[14] = Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[15] = Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+	return keptCount;
+}
 
-	// Fill in the left face vertex data.
-	v[16] = Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-	v[17] = Vertex(-w2, +h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-	v[18] = Vertex(-w2, +h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-	v[19] = Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
+GeometryGenerator::VertexCacheReport GeometryGenerator::OptimizeVertexCache(MeshData& meshData, uint32 cacheSize)
+{
+	VertexCacheReport report;
+	report.m_before = AnalyzeVertexCache(meshData, cacheSize);
 
-	// Fill in the right face vertex data.
-	v[20] = Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-	v[21] = Vertex(+w2, +h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-	v[22] = Vertex(+w2, +h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-	v[23] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+	uint32 vertexCount = (uint32)meshData.m_vertices.size();
+	uint32 numTris = (uint32)meshData.m_indices32.size() / 3;
 
-	meshData.m_vertices.assign(&v[0], &v[24]);
+	if (numTris == 0)
+	{
+		report.m_after = report.m_before;
+		return report;
+	}
 
 	//
-	// Create the indices.
+	// Build the vertex to triangle adjacency in compressed rows.
 	//
 
-	uint32 i[36];
+	std::pmr::vector<uint32> liveTriCount(vertexCount, 0, m_resource);
+	for (uint32 index : meshData.m_indices32)
+		++liveTriCount[index];
 
-	// Fill in the front face index data
-	i[0] = 0; i[1] = 1; i[2] = 2;
-	i[3] = 0; i[4] = 2; i[5] = 3;
+	std::pmr::vector<uint32> adjOffset(vertexCount + 1, 0, m_resource);
+	for (uint32 v = 0; v < vertexCount; ++v)
+		adjOffset[v + 1] = adjOffset[v] + liveTriCount[v];
 
-	// Fill in the back face index data
-	i[6] = 4; i[7] = 5; i[8] = 6;
-	i[9] = 4; i[10] = 6; i[11] = 7;
+	std::pmr::vector<uint32> adjTris(meshData.m_indices32.size(), m_resource);
+	std::pmr::vector<uint32> adjFill(adjOffset.begin(), adjOffset.end() - 1, m_resource);
+	for (uint32 t = 0; t < numTris; ++t)
+	{
+		for (uint32 k = 0; k < 3; ++k)
+			adjTris[adjFill[meshData.m_indices32[t * 3 + k]]++] = t;
+	}
 
-	// Fill in the top face index data
-	i[12] = 8; i[13] = 9; i[14] = 10;
-	i[15] = 8; i[16] = 10; i[17] = 11;
+	//
+	// Tipsify (Sander, Nehab and Barczak 2007).  Fan around a vertex, emitting all of
+	// its remaining triangles, then pick the next fanning vertex among the ones just
+	// referenced that is still likely to be in the cache.
+	//
 
-	// Fill in the bottom face index data
-	i[18] = 12; i[19] = 13; i[20] = 14;
-	i[21] = 12; i[22] = 14; i[23] = 15;
+	std::pmr::vector<uint32> cacheTime(vertexCount, 0, m_resource);
+	std::pmr::vector<bool> emitted(numTris, false, m_resource);
+	std::pmr::vector<uint32> deadEnd(m_resource);
+	std::pmr::vector<uint32> candidates(m_resource);
 
-	// Fill in the left face index data
-	i[24] = 16; i[25] = 17; i[26] = 18;
-	i[27] = 16; i[28] = 18; i[29] = 19;
+	std::pmr::vector<uint32> outIndices(meshData.m_indices32.get_allocator());
+	outIndices.reserve(meshData.m_indices32.size());
 
-	// Fill in the right face index data
-	i[30] = 20; i[31] = 21; i[32] = 22;
-	i[33] = 20; i[34] = 22; i[35] = 23;
+	uint32 timeStamp = cacheSize + 1;
+	uint32 cursor = 0;
+	int fanVertex = (int)meshData.m_indices32[0];
 
-	meshData.m_indices32.assign(&i[0], &i[36]);
+	while (fanVertex >= 0)
+	{
+		candidates.clear();
 
-	// Put a cap on the number of subdivisions.
-	numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
+		for (uint32 a = adjOffset[fanVertex]; a < adjOffset[fanVertex + 1]; ++a)
+		{
+			uint32 t = adjTris[a];
+			if (emitted[t])
+				continue;
+
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				uint32 v = meshData.m_indices32[t * 3 + k];
+				outIndices.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				--liveTriCount[v];
+
+				// Not in the cache, so it is transformed and enters it now.
+				if (timeStamp - cacheTime[v] > cacheSize)
+					cacheTime[v] = timeStamp++;
+			}
+
+			emitted[t] = true;
+		}
 
-	for (uint32 i = 0; i < numSubdivisions; ++i)
-		Subdivide(meshData);
+		// Prefer the candidate that is still in the cache and will stay there while its
+		// remaining triangles are emitted, and among those the oldest one.
+		fanVertex = -1;
+		int bestPriority = -1;
+		for (uint32 v : candidates)
+		{
+			if (liveTriCount[v] == 0)
+				continue;
+
+			int priority = 0;
+			if (timeStamp - cacheTime[v] + 2 * liveTriCount[v] <= cacheSize)
+				priority = (int)(timeStamp - cacheTime[v]);
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				fanVertex = (int)v;
+			}
+		}
 
-	return meshData;
-}
+		if (fanVertex >= 0)
+			continue;
 
-GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32 sliceCount, uint32 stackCount)
-{
-	MeshData meshData;
+		// Dead end, so back track through the recently referenced vertices, then fall
+		// back to scanning the input order for any vertex with triangles left.
+		while (!deadEnd.empty() && fanVertex < 0)
+		{
+			uint32 v = deadEnd.back();
+			deadEnd.pop_back();
+
+			if (liveTriCount[v] > 0)
+				fanVertex = (int)v;
+		}
+
+		while (cursor < vertexCount && fanVertex < 0)
+		{
+			if (liveTriCount[cursor] > 0)
+				fanVertex = (int)cursor;
+
+			++cursor;
+		}
+	}
 
 	//
-	// Compute the vertices stating at the top pole and moving down the stacks.
+	// Reorder the vertices by first use so vertex fetch walks the buffer linearly.
+	// Vertices that no triangle references are kept at the end.
 	//
 
-	// Poles: note that there will be texture coordinate distortion as there is
-	// not a unique point on the texture map to assign to the pole when mapping
-	// a rectangular texture onto a sphere.
-	Vertex topVertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	Vertex bottomVertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	const uint32 unassigned = 0xffffffff;
+	std::pmr::vector<uint32> remap(vertexCount, unassigned, m_resource);
 
-	meshData.m_vertices.push_back(topVertex);
+	uint32 nextVertex = 0;
+	for (uint32& index : outIndices)
+	{
+		if (remap[index] == unassigned)
+			remap[index] = nextVertex++;
 
-	float phiStep = DirectX::XM_PI / stackCount;
-	float thetaStep = 2.0f * DirectX::XM_PI / sliceCount;
+		index = remap[index];
+	}
 
-	// Compute vertices for each stack ring (do not count the poles as rings).
-	for (uint32 i = 1; i <= stackCount - 1; ++i)
+	for (uint32 v = 0; v < vertexCount; ++v)
 	{
-		float phi = i * phiStep;
+		if (remap[v] == unassigned)
+			remap[v] = nextVertex++;
+	}
 
-		// Vertices of ring.
-		for (uint32 j = 0; j <= sliceCount; ++j)
-		{
-			float theta = j * thetaStep;
+	std::pmr::vector<Vertex> outVertices(vertexCount, meshData.m_vertices.get_allocator());
+	for (uint32 v = 0; v < vertexCount; ++v)
+		outVertices[remap[v]] = meshData.m_vertices[v];
 
-			Vertex v;
+	meshData.m_vertices.swap(outVertices);
+	meshData.m_indices32.swap(outIndices);
+	meshData.m_indices16.clear();
 
-			// spherical to cartesian
-			v.m_position.x = radius * sinf(phi) * cosf(theta);
-			v.m_position.y = radius * cosf(phi);
-			v.m_position.z = radius * sinf(phi) * sinf(theta);
+	report.m_after = AnalyzeVertexCache(meshData, cacheSize);
 
-			// Partial derivative of P with respect to theta
-			v.m_tangentU.x = -radius * sinf(phi) * sinf(theta);
-			v.m_tangentU.y = 0.0f;
-			v.m_tangentU.z = +radius * sinf(phi) * cosf(theta);
+	return report;
+}
+
+GeometryGenerator::VertexCacheStats GeometryGenerator::AnalyzeVertexCache(const MeshData& meshData, uint32 cacheSize)
+{
+	VertexCacheStats stats;
 
-			DirectX::XMVECTOR T = DirectX::XMLoadFloat3(&v.m_tangentU);
-			DirectX::XMStoreFloat3(&v.m_tangentU, DirectX::XMVector3Normalize(T));
+	uint32 numTris = (uint32)meshData.m_indices32.size() / 3;
+	if (numTris == 0 || cacheSize == 0)
+		return stats;
 
-			DirectX::XMVECTOR p = DirectX::XMLoadFloat3(&v.m_position);
-			DirectX::XMStoreFloat3(&v.m_normal, DirectX::XMVector3Normalize(p));
+	// A vertex is in the FIFO cache if fewer than cacheSize misses happened since it
+	// last entered it.  Its stamp is the miss count just after it entered, so zero means
+	// never transformed.
+	std::pmr::vector<uint32> missStamp(meshData.m_vertices.size(), 0, m_resource);
 
-			v.m_texC.x = theta / DirectX::XM_2PI;
-			v.m_texC.y = phi / DirectX::XM_PI;
+	uint32 misses = 0;
+	uint32 uniqueVertices = 0;
+	for (uint32 index : meshData.m_indices32)
+	{
+		if (missStamp[index] == 0)
+			++uniqueVertices;
+		else if (misses - missStamp[index] < cacheSize)
+			continue;
 
-			meshData.m_vertices.push_back(v);
-		}
+		missStamp[index] = ++misses;
 	}
 
-	meshData.m_vertices.push_back(bottomVertex);
+	stats.m_acmr = (float)misses / numTris;
+	stats.m_atvr = (float)misses / uniqueVertices;
 
-	//
-	// Compute indices for top stack.  The top stack was written first to the vertex buffer
-	// and connects the top pole to the first ring.
-	//
+	return stats;
+}
 
-	for (uint32 i = 1; i <= sliceCount; ++i)
+bool GeometryGenerator::PartitionIndices16(MeshData& meshData, std::vector<IndexPartition>& partitions, uint32 vertexByteStride)
+{
+	const uint32 maxPartitionVertices = 0x10000;
+
+	uint32 vertexCount = (uint32)meshData.m_vertices.size();
+	uint32 indexCount = (uint32)meshData.m_indices32.size();
+	uint32 numTris = indexCount / 3;
+
+	partitions.clear();
+
+	IndexPartition whole;
+	whole.m_indexCount = indexCount;
+	whole.m_vertexCount = vertexCount;
+
+	// Already addressable with 16-bit indices.
+	if (vertexCount <= maxPartitionVertices)
 	{
-		meshData.m_indices32.push_back(0);
-		meshData.m_indices32.push_back(i + 1);
-		meshData.m_indices32.push_back(i);
+		partitions.push_back(whole);
+		return true;
 	}
 
 	//
-	// Compute indices for inner stacks (not connected to poles).
+	// Greedily grow each partition over consecutive triangles until the next triangle
+	// would take it past the 16-bit limit.
 	//
-	uint32 baseIndex = 1;
-	uint32 ringVertexCount = sliceCount + 1;
-	for (uint32 i = 0; i < stackCount - 2; ++i)
+
+	const uint32 unassigned = 0xffffffff;
+	std::pmr::vector<uint32> owner(vertexCount, unassigned, m_resource);
+	std::pmr::vector<uint32> localIndex(vertexCount, 0, m_resource);
+
+	std::pmr::vector<Vertex> outVertices(meshData.m_vertices.get_allocator());
+	std::pmr::vector<uint32> outIndices(meshData.m_indices32.get_allocator());
+	outVertices.reserve(vertexCount);
+	outIndices.reserve(indexCount);
+
+	IndexPartition current;
+
+	for (uint32 t = 0; t < numTris; ++t)
 	{
-		for (uint32 j = 0; j < sliceCount; ++j)
+		const uint32* tri = &meshData.m_indices32[t * 3];
+
+		// Count the distinct vertices of the triangle not yet in this partition.
+		uint32 newVertices = 0;
+		for (uint32 k = 0; k < 3; ++k)
+		{
+			if (owner[tri[k]] != (uint32)partitions.size() &&
+				(k == 0 || tri[k] != tri[0]) && (k < 2 || tri[k] != tri[1]))
+				++newVertices;
+		}
+
+		if (current.m_vertexCount + newVertices > maxPartitionVertices)
 		{
-			meshData.m_indices32.push_back(baseIndex + i * ringVertexCount + j);
-			meshData.m_indices32.push_back(baseIndex + i * ringVertexCount + j + 1);
-			meshData.m_indices32.push_back(baseIndex + (i + 1) * ringVertexCount + j);
+			partitions.push_back(current);
 
-			meshData.m_indices32.push_back(baseIndex + (i + 1) * ringVertexCount + j);
-			meshData.m_indices32.push_back(baseIndex + i * ringVertexCount + j + 1);
-			meshData.m_indices32.push_back(baseIndex + (i + 1) * ringVertexCount + j + 1);
+			current = IndexPartition();
+			current.m_startIndexLocation = (uint32)outIndices.size();
+			current.m_baseVertexLocation = (int)outVertices.size();
 		}
-	}
 
-	//
-	// Compute indices for bottom stack.  The bottom stack was written last to the vertex buffer
-	// and connects the bottom pole to the bottom ring.
-	//
+		for (uint32 k = 0; k < 3; ++k)
+		{
+			uint32 v = tri[k];
+			if (owner[v] != (uint32)partitions.size())
+			{
+				owner[v] = (uint32)partitions.size();
+				localIndex[v] = current.m_vertexCount++;
+				outVertices.push_back(meshData.m_vertices[v]);
+			}
+
+			outIndices.push_back(localIndex[v]);
+		}
 
-	// South pole vertex was added last.
-	uint32 southPoleIndex = (uint32)meshData.m_vertices.size() - 1;
+		current.m_indexCount += 3;
+	}
 
-	// Offset the indices to the index of the first vertex in the last ring.
-	baseIndex = southPoleIndex - ringVertexCount;
+	partitions.push_back(current);
 
-	for (uint32 i = 0; i < sliceCount; ++i)
+	// Each duplicated vertex costs a full vertex while the split saves two bytes per index.
+	std::uint64_t duplicateBytes = outVertices.size() > vertexCount
+		? (std::uint64_t)(outVertices.size() - vertexCount) * vertexByteStride : 0;
+	std::uint64_t savedBytes = (std::uint64_t)indexCount * (sizeof(uint32) - sizeof(uint16));
+
+	if (duplicateBytes >= savedBytes)
 	{
-		meshData.m_indices32.push_back(southPoleIndex);
-		meshData.m_indices32.push_back(baseIndex + i);
-		meshData.m_indices32.push_back(baseIndex + i + 1);
+		partitions.clear();
+		partitions.push_back(whole);
+		return false;
 	}
 
-	return meshData;
+	meshData.m_vertices.swap(outVertices);
+	meshData.m_indices32.swap(outIndices);
+	meshData.m_indices16.clear();
+
+	return true;
 }
 
-GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uint32 numSubdivisions)
+GeometryGenerator::MeshData GeometryGenerator::BuildUnitGeosphere(uint32 numSubdivisions)
 {
-	MeshData meshData;
-
-	// Put a cap on the number of subdivisions.
-	numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
+	// The cache outlives any arena the generator was given, so it lives on the heap.
+	MeshData meshData(std::pmr::new_delete_resource());
 
 	// Approximate a sphere by tessellating an
 	//icosahedron.
-	const float X = 0.525731f;
-	const float Z = 0.850651f;
-
-	DirectX::XMFLOAT3 pos[12] =
-	{
-	DirectX::XMFLOAT3(-X, 0.0f, Z), DirectX::XMFLOAT3(X, 0.0f, Z),
-	DirectX::XMFLOAT3(-X, 0.0f, -Z), DirectX::XMFLOAT3(X, 0.0f, -Z),
-	DirectX::XMFLOAT3(0.0f, Z, X), DirectX::XMFLOAT3(0.0f, Z, -X),
-	DirectX::XMFLOAT3(0.0f, -Z, X), DirectX::XMFLOAT3(0.0f, -Z, -X),
-	DirectX::XMFLOAT3(Z, X, 0.0f), DirectX::XMFLOAT3(-Z, X, 0.0f),
-	DirectX::XMFLOAT3(Z, -X, 0.0f), DirectX::XMFLOAT3(-Z, -X, 0.0f)
-	};
-
-	uint32 k[60] =
-	{
-	1,4,0, 4,9,0, 4,5,9, 8,5,4, 1,8,4,
-	1,10,8, 10,3,8, 8,3,5, 3,2,5, 3,7,2,
-	3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0,
-	10,1,6, 11,0,9, 2,11,9, 5,2,9, 11,2,7
-	};
-
 	meshData.m_vertices.resize(12);
 
-	meshData.m_indices32.assign(&k[0], &k[60]);
+	meshData.m_indices32.assign(std::begin(GeometryTables::s_icosahedronIndices), std::end(GeometryTables::s_icosahedronIndices));
 
 	for (uint32 i = 0; i < 12; ++i)
-		meshData.m_vertices[i].m_position = pos[i];
+		meshData.m_vertices[i].m_position = GeometryTables::s_icosahedronPositions[i];
 
 	for (uint32 i = 0; i < numSubdivisions; ++i)
 		Subdivide(meshData);
 
-	// Project vertices onto sphere and scale.
+	// Project vertices onto the unit sphere.
 	for (uint32 i = 0; i < meshData.m_vertices.size(); ++i)
 	{
-		// Project onto unit sphere.
-
-		// Project onto sphere.
 		DirectX::XMVECTOR n = DirectX::XMVector3Normalize(DirectX::XMLoadFloat3(&meshData.m_vertices[i].m_position));
-		DirectX::XMVECTOR p = DirectX::XMVectorScale(n, radius);
 
-		DirectX::XMStoreFloat3(&meshData.m_vertices[i].m_position, p);
+		DirectX::XMStoreFloat3(&meshData.m_vertices[i].m_position, n);
 		DirectX::XMStoreFloat3(&meshData.m_vertices[i].m_normal, n);
 
 		// Derive texture coordinates from spherical
@@ -364,20 +2822,19 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uin
 		if (theta < 0.0f)
 			theta += DirectX::XM_2PI;
 
-		float phi = acosf(meshData.m_vertices[i].m_position.y
-			/ radius);
+		float phi = acosf(meshData.m_vertices[i].m_position.y);
 
 		meshData.m_vertices[i].m_texC.x = theta / DirectX::XM_2PI;
 		meshData.m_vertices[i].m_texC.y = phi / DirectX::XM_PI;
 
 		// Partial derivative of P with respect to theta
 		meshData.m_vertices[i].m_tangentU.x = -
-			radius * sinf(phi) * sinf(theta);
+			sinf(phi) * sinf(theta);
 
 		meshData.m_vertices[i].m_tangentU.y = 0.0f;
 
 		meshData.m_vertices[i].m_tangentU.z =
-			+radius * sinf(phi) * cosf(theta);
+			+sinf(phi) * cosf(theta);
 
 		DirectX::XMVECTOR T = XMLoadFloat3(&meshData.m_vertices[i].m_tangentU);
 		DirectX::XMStoreFloat3(&meshData.m_vertices[i].m_tangentU,
@@ -387,136 +2844,41 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uin
 	return meshData;
 }
 
-GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount)
+void GeometryGenerator::Subdivide(MeshData& meshData)
 {
-	MeshData meshData;
-
-	//
-	// Build Stacks.
-	//
-
-	float stackHeight = height / stackCount;
-
-	// Amount to increment radius as we move up each stack level from bottom to top.
-	float radiusStep = (topRadius - bottomRadius) / stackCount;
-
-	uint32 ringCount = stackCount + 1;
-
-	// Compute vertices for each stack ring starting at the bottom and moving up.
-	for (uint32 i = 0; i < ringCount; ++i)
-	{
-		float y = -0.5f * height + i * stackHeight;
-		float r = bottomRadius + i * radiusStep;
-
-		// vertices of ring
-		float dTheta = 2.0f * DirectX::XM_PI / sliceCount;
-		for (uint32 j = 0; j <= sliceCount; ++j)
-		{
-			Vertex vertex;
-
-			float c = cosf(j * dTheta);
-			float s = sinf(j * dTheta);
-
-			vertex.m_position = DirectX::XMFLOAT3(r * c, y, r * s);
-
-			vertex.m_texC.x = (float)j / sliceCount;
-			vertex.m_texC.y = 1.0f - (float)i / stackCount;
-
-			// Cylinder can be parameterized as follows, where we introduce v
-			// parameter that goes in the same direction as the v tex-coord
-			// so that the bitangent goes in the same direction as the v tex-coord.
-			//   Let r0 be the bottom radius and let r1 be the top radius.
-			/*
-				y(v) = h - hv for v in[0, 1].
-				r(v) = r1 + (r0-r1)v
-
-				x(t, v) = r(v)*cos(t)
-				y(t, v) = h - hv
-				z(t, v) = r(v)*sin(t)
-
-				dx/dt = -r(v)*sin(t)
-				dy/dt = 0
-				dz/dt = +r(v)*cos(t)
-
-				dx/dv = (r0-r1)*cos(t)
-				dy/dv = -h
-				dz/dv = (r0-r1)*sin(t)
-			*/
-
-			// This is unit length.
-			vertex.m_tangentU = DirectX::XMFLOAT3(-s, 0.0f, c);
+	// Save a copy of the input indices.  The input vertices stay where they
+	// are and the midpoint vertices are appended after them.
+	std::pmr::vector<uint32> inputIndices(meshData.m_indices32.get_allocator());
+	inputIndices.swap(meshData.m_indices32);
 
-			float dr = bottomRadius - topRadius;
-			DirectX::XMFLOAT3 bitangent(dr * c, -height, dr * s);
+	uint32 numTris = (uint32)inputIndices.size() / 3;
 
-			DirectX::XMVECTOR T = DirectX::XMLoadFloat3(&vertex.m_tangentU);
-			DirectX::XMVECTOR B = DirectX::XMLoadFloat3(&bitangent);
-			DirectX::XMVECTOR N = DirectX::XMVector3Normalize(DirectX::XMVector3Cross(T, B));
-			DirectX::XMStoreFloat3(&vertex.m_normal, N);
-
-			meshData.m_vertices.push_back(vertex);
-		}
-	}
+	// An interior edge is shared by two triangles, so a closed mesh gains one
+	// vertex per edge (3/2 per triangle) and every triangle becomes four.
+	meshData.m_vertices.reserve(meshData.m_vertices.size() + numTris * 3 / 2 + 3);
+	meshData.m_indices32.reserve(numTris * 12);
 
-	// Add one because we duplicate the first and last vertex per ring
-	// since the texture coordinates are different.
-	uint32 ringVertexCount = sliceCount + 1;
+	// Cache the midpoint of each edge keyed by its sorted vertex pair so the
+	// neighbouring triangle reuses it rather than emitting a duplicate.
+	std::pmr::unordered_map<std::uint64_t, uint32> midPointCache(meshData.m_indices32.get_allocator().resource());
+	midPointCache.reserve(numTris * 3 / 2 + 3);
 
-	// Compute indices for each stack.
-	for (uint32 i = 0; i < stackCount; ++i)
+	auto getMidPoint = [&](uint32 i0, uint32 i1)
 	{
-		for (uint32 j = 0; j < sliceCount; ++j)
-		{
-			meshData.m_indices32.push_back(i * ringVertexCount + j);
-			meshData.m_indices32.push_back((i + 1) * ringVertexCount + j);
-			meshData.m_indices32.push_back((i + 1) * ringVertexCount + j + 1);
-
-			meshData.m_indices32.push_back(i * ringVertexCount + j);
-			meshData.m_indices32.push_back((i + 1) * ringVertexCount + j + 1);
-			meshData.m_indices32.push_back(i * ringVertexCount + j + 1);
-		}
-	}
-
-	BuildCylinderTopCap(topRadius, height, sliceCount, meshData);
-	BuildCylinderBottomCap(bottomRadius, height, sliceCount, meshData);
+		std::uint64_t key = i0 < i1
+			? ((std::uint64_t)i0 << 32) | i1
+			: ((std::uint64_t)i1 << 32) | i0;
 
-	return meshData;
-}
-
-GeometryGenerator::MeshData GeometryGenerator::CreateQuad(float x, float y, float w, float h, float depth)
-{
-	MeshData meshData;
-
-	meshData.m_vertices.resize(4);
-	meshData.m_indices32.resize(6);
-
-	// Position coordinates specified in NDC space.
-	meshData.m_vertices[0] = Vertex(x, y - h, depth, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-
-	meshData.m_vertices[1] = Vertex(x, y, depth, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+		auto it = midPointCache.find(key);
+		if (it != midPointCache.end())
+			return it->second;
 
-	meshData.m_vertices[2] = Vertex(x + w, y, depth, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-	meshData.m_vertices[3] = Vertex(x + w, y - h, depth, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-	meshData.m_indices32[0] = 0;
-	meshData.m_indices32[1] = 1;
-	meshData.m_indices32[2] = 2;
-
-	meshData.m_indices32[3] = 0;
-	meshData.m_indices32[4] = 2;
-	meshData.m_indices32[5] = 3;
-
-	return meshData;
-}
-
-void GeometryGenerator::Subdivide(MeshData& meshData)
-{
-	// Save a copy of the input geometry.
-	MeshData inputCopy = meshData;
+		uint32 index = (uint32)meshData.m_vertices.size();
+		meshData.m_vertices.push_back(MidPoint(meshData.m_vertices[i0], meshData.m_vertices[i1]));
+		midPointCache.emplace(key, index);
 
-	meshData.m_vertices.resize(0);
-	meshData.m_indices32.resize(0);
+		return index;
+	};
 
 	//       v1
 	//       *
@@ -528,43 +2890,35 @@ void GeometryGenerator::Subdivide(MeshData& meshData)
 	// *-----*-----*
 	// v0    m2     v2
 
-	uint32 numTris = (uint32)inputCopy.m_indices32.size() / 3;
 	for (uint32 i = 0; i < numTris; ++i)
 	{
-		Vertex v0 = inputCopy.m_vertices[inputCopy.m_indices32[i * 3 + 0]];
-		Vertex v1 = inputCopy.m_vertices[inputCopy.m_indices32[i * 3 + 1]];
-		Vertex v2 = inputCopy.m_vertices[inputCopy.m_indices32[i * 3 + 2]];
+		uint32 v0 = inputIndices[i * 3 + 0];
+		uint32 v1 = inputIndices[i * 3 + 1];
+		uint32 v2 = inputIndices[i * 3 + 2];
 
 		//
 		// Generate the midpoints.
 		//
 
-		Vertex m0 = MidPoint(v0, v1);
-		Vertex m1 = MidPoint(v1, v2);
-		Vertex m2 = MidPoint(v0, v2);
+		uint32 m0 = getMidPoint(v0, v1);
+		uint32 m1 = getMidPoint(v1, v2);
+		uint32 m2 = getMidPoint(v0, v2);
 
-		meshData.m_vertices.push_back(v0); // 0
-		meshData.m_vertices.push_back(v1); // 1
-		meshData.m_vertices.push_back(v2); // 2
-		meshData.m_vertices.push_back(m0); // 3
-		meshData.m_vertices.push_back(m1); // 4
-		meshData.m_vertices.push_back(m2); // 5
+		meshData.m_indices32.push_back(v0);
+		meshData.m_indices32.push_back(m0);
+		meshData.m_indices32.push_back(m2);
 
-		meshData.m_indices32.push_back(i * 6 + 0);
-		meshData.m_indices32.push_back(i * 6 + 3);
-		meshData.m_indices32.push_back(i * 6 + 5);
+		meshData.m_indices32.push_back(m0);
+		meshData.m_indices32.push_back(m1);
+		meshData.m_indices32.push_back(m2);
 
-		meshData.m_indices32.push_back(i * 6 + 3);
-		meshData.m_indices32.push_back(i * 6 + 4);
-		meshData.m_indices32.push_back(i * 6 + 5);
+		meshData.m_indices32.push_back(m2);
+		meshData.m_indices32.push_back(m1);
+		meshData.m_indices32.push_back(v2);
 
-		meshData.m_indices32.push_back(i * 6 + 5);
-		meshData.m_indices32.push_back(i * 6 + 4);
-		meshData.m_indices32.push_back(i * 6 + 2);
-
-		meshData.m_indices32.push_back(i * 6 + 3);
-		meshData.m_indices32.push_back(i * 6 + 1);
-		meshData.m_indices32.push_back(i * 6 + 4);
+		meshData.m_indices32.push_back(m0);
+		meshData.m_indices32.push_back(v1);
+		meshData.m_indices32.push_back(m1);
 	}
 }
 
@@ -599,18 +2953,47 @@ GeometryGenerator::Vertex GeometryGenerator::MidPoint(const Vertex& v0, const Ve
 	return v;
 }
 
-void GeometryGenerator::BuildCylinderTopCap(float topRadius, float height, uint32 sliceCount, MeshData& meshData)
+void GeometryGenerator::BuildSliceTable(uint32 sliceCount, std::pmr::vector<float>& cosTheta, std::pmr::vector<float>& sinTheta)
+{
+	uint32 count = sliceCount + 1;
+	float dTheta = 2.0f * DirectX::XM_PI / sliceCount;
+
+	// Round the tables up to a multiple of four so they can be filled four angles at a
+	// time with the vectorised sine and cosine, then drop the padding.
+	uint32 paddedCount = (count + 3) & ~3u;
+	cosTheta.resize(paddedCount);
+	sinTheta.resize(paddedCount);
+
+	DirectX::XMVECTOR step = DirectX::XMVectorReplicate(dTheta);
+	for (uint32 j = 0; j < count; j += 4)
+	{
+		DirectX::XMVECTOR theta = DirectX::XMVectorMultiply(
+			DirectX::XMVectorSet((float)j, (float)(j + 1), (float)(j + 2), (float)(j + 3)), step);
+
+		DirectX::XMVECTOR s;
+		DirectX::XMVECTOR c;
+		DirectX::XMVectorSinCos(&s, &c, theta);
+
+		DirectX::XMStoreFloat4(reinterpret_cast<DirectX::XMFLOAT4*>(&cosTheta[j]), c);
+		DirectX::XMStoreFloat4(reinterpret_cast<DirectX::XMFLOAT4*>(&sinTheta[j]), s);
+	}
+
+	cosTheta.resize(count);
+	sinTheta.resize(count);
+}
+
+void GeometryGenerator::BuildCylinderTopCap(float topRadius, float height, uint32 sliceCount,
+	const std::pmr::vector<float>& cosTheta, const std::pmr::vector<float>& sinTheta, MeshData& meshData)
 {
 	uint32 baseIndex = (uint32)meshData.m_vertices.size();
 
 	float y = 0.5f * height;
-	float dTheta = 2.0f * DirectX::XM_PI / sliceCount;
 
 	// Duplicate cap ring vertices because the texture coordinates and normals differ.
 	for (uint32 i = 0; i <= sliceCount; ++i)
 	{
-		float x = topRadius * cosf(i * dTheta);
-		float z = topRadius * sinf(i * dTheta);
+		float x = topRadius * cosTheta[i];
+		float z = topRadius * sinTheta[i];
 
 		// Scale down by the height to try and make top cap texture coord area proportional to base.
 		float u = x / height + 0.5f;
@@ -631,17 +3014,17 @@ void GeometryGenerator::BuildCylinderTopCap(float topRadius, float height, uint3
 		meshData.m_indices32.push_back(baseIndex + i);
 	}
 }
-void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float height, uint32 sliceCount, MeshData& meshData)
+void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float height, uint32 sliceCount,
+	const std::pmr::vector<float>& cosTheta, const std::pmr::vector<float>& sinTheta, MeshData& meshData)
 {
 	uint32 baseIndex = (uint32)meshData.m_vertices.size();
 	float y = -0.5f * height;
 
 	// vertices of ring
-	float dTheta = 2.0f * DirectX::XM_PI / sliceCount;
 	for (uint32 i = 0; i <= sliceCount; ++i)
 	{
-		float x = bottomRadius * cosf(i * dTheta);
-		float z = bottomRadius * sinf(i * dTheta);
+		float x = bottomRadius * cosTheta[i];
+		float z = bottomRadius * sinTheta[i];
 
 		// Scale down by the height to try and make top cap texture coord area proportional to base.
 		float u = x / height + 0.5f;
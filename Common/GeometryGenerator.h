@@ -16,7 +16,11 @@
 // As a learning opportunity I'd like to spend some time understanding and rewriting the code found within.
 
 #include <cstdint>
+#include <DirectXCollision.h>
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <atomic>
+#include <memory_resource>
 #include <vector>
 
 using uint16 = std::uint16_t;
@@ -27,15 +31,37 @@ class GeometryGenerator
 public:
 	struct Vertex
 	{
-		Vertex();
-		Vertex(const DirectX::XMFLOAT3& pos,
+		// The constructors are constexpr so fixed meshes can be built at compile time,
+		// see GeometryTables below.
+		constexpr Vertex()
+			: m_position(0, 0, 0),
+			m_normal(0, 0, 0),
+			m_tangentU(0, 0, 0),
+			m_texC(0, 0)
+		{
+		}
+
+		constexpr Vertex(const DirectX::XMFLOAT3& pos,
 			const DirectX::XMFLOAT3& norm,
 			const DirectX::XMFLOAT3& tang,
-			const DirectX::XMFLOAT2& uv);
-		Vertex(float px, float py, float pz,
+			const DirectX::XMFLOAT2& uv)
+			: m_position(pos),
+			m_normal(norm),
+			m_tangentU(tang),
+			m_texC(uv)
+		{
+		}
+
+		constexpr Vertex(float px, float py, float pz,
 			float nx, float ny, float nz,
 			float tx, float ty, float tz,
-			float u, float v);
+			float u, float v)
+			: m_position(px, py, pz),
+			m_normal(nx, ny, nz),
+			m_tangentU(tx, ty, tz),
+			m_texC(u, v)
+		{
+		}
 
 		DirectX::XMFLOAT3 m_position;
 		DirectX::XMFLOAT3 m_normal;
@@ -43,20 +69,271 @@ public:
 		DirectX::XMFLOAT2 m_texC;
 	};
 
+	// The arrays of a MeshData are allocated from the memory resource it was created
+	// with.  Copies use the default resource; moves keep the source's.
 	struct MeshData
 	{
-		std::vector<Vertex> m_vertices;
-		std::vector<uint32> m_indices32;
+		MeshData() = default;
+		explicit MeshData(std::pmr::memory_resource* resource);
+
+		std::pmr::vector<Vertex> m_vertices;
+		std::pmr::vector<uint32> m_indices32;
+
+		// Bounds of the vertex positions.  The generators fill these in as they
+		// build the mesh; call ComputeBounds after editing the positions.
+		DirectX::BoundingBox m_boundingBox;
+		DirectX::BoundingSphere m_boundingSphere;
+
+		// The indices as 16-bit values, converted on first use.  Throws std::out_of_range
+		// if any index is above 0xffff; split such meshes with PartitionIndices16 first.
+		std::pmr::vector<uint16>& GetIndices16();
+
+	private:
+		friend class GeometryGenerator;
+
+		std::pmr::vector<uint16> m_indices16;
+	};
+
+	// A memory resource that passes every request on to another one and counts them.
+	// Use it as the upstream of an arena to check that generating a scene never goes
+	// back to the heap, or as the default resource to catch stray allocations.
+	class AllocationCounter : public std::pmr::memory_resource
+	{
+	public:
+		explicit AllocationCounter(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+		size_t GetAllocationCount() const { return m_allocationCount.load(); }
+		size_t GetBytesAllocated() const { return m_bytesAllocated.load(); }
 
-		std::vector<uint16>& GetIndices16();
+		void Reset();
 
 	private:
-		std::vector<uint16> m_indices16;
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+		std::pmr::memory_resource* m_upstream;
+		std::atomic<size_t> m_allocationCount{ 0 };
+		std::atomic<size_t> m_bytesAllocated{ 0 };
+	};
+
+	struct VertexCacheStats
+	{
+		// Average cache miss ratio: vertices transformed per triangle (0.5 is the ideal for a large mesh).
+		float m_acmr = 0.0f;
+
+		// Average transform to vertex ratio: vertices transformed per unique vertex (1.0 is the ideal).
+		float m_atvr = 0.0f;
+	};
+
+	struct VertexCacheReport
+	{
+		VertexCacheStats m_before;
+		VertexCacheStats m_after;
+	};
+
+	// A 20 byte vertex, against 44 for Vertex.  Positions are 16-bit unorm within the
+	// mesh's bounding box, normals and tangents are octahedral encoded snorm pairs and
+	// texture coordinates are half floats.  The matching DXGI formats are
+	// R16G16B16A16_UNORM, R16G16_SNORM, R16G16_SNORM and R16G16_FLOAT.
+	struct PackedVertex
+	{
+		DirectX::PackedVector::XMUSHORTN4 m_position;
+		DirectX::PackedVector::XMSHORTN2 m_normal;
+		DirectX::PackedVector::XMSHORTN2 m_tangentU;
+		DirectX::PackedVector::XMHALF2 m_texC;
+	};
+
+	struct PackedMeshData
+	{
+		std::vector<PackedVertex> m_vertices;
+
+		// The vertex shader recovers a position as m_position.xyz * m_positionScale + m_positionBias.
+		DirectX::XMFLOAT3 m_positionScale = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+		DirectX::XMFLOAT3 m_positionBias = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+	};
+
+	// Largest differences between a mesh's vertices and their packed versions.
+	struct PackingError
+	{
+		float m_maxPositionError = 0.0f;
+
+		// Angles in degrees.
+		float m_maxNormalError = 0.0f;
+		float m_maxTangentError = 0.0f;
+
+		float m_maxTexCError = 0.0f;
+	};
+
+	// A cluster of at most 64 vertices and 124 triangles, addressed through the arrays of
+	// a MeshletData.  Plain data, so a MeshletData can be written out as is.
+	struct Meshlet
+	{
+		// Range of MeshletData::m_vertexIndices holding this meshlet's vertices.
+		uint32 m_vertexOffset = 0;
+		uint32 m_vertexCount = 0;
+
+		// Range of triangles in MeshletData::m_primitiveIndices, three local indices each.
+		uint32 m_primitiveOffset = 0;
+		uint32 m_primitiveCount = 0;
+
+		DirectX::XMFLOAT3 m_center = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+		float m_radius = 0.0f;
+
+		// Backface cone: the meshlet faces away from an eye at e when
+		// dot(normalize(m_coneApex - e), m_coneAxis) >= m_coneCutoff.  The cutoff
+		// is above one for meshlets whose normals are too spread out to cull.
+		DirectX::XMFLOAT3 m_coneApex = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+		DirectX::XMFLOAT3 m_coneAxis = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+		float m_coneCutoff = 2.0f;
+	};
+
+	struct MeshletData
+	{
+		std::vector<Meshlet> m_meshlets;
+
+		// Indices into the source mesh's vertices, m_vertexCount per meshlet.
+		std::vector<uint32> m_vertexIndices;
+
+		// Triangles as indices into the meshlet's slice of m_vertexIndices.
+		std::vector<std::uint8_t> m_primitiveIndices;
 	};
 
+	// Describes where each attribute lives in a caller's vertex structure so the
+	// generated vertices can be written straight into a vertex buffer.  Attributes
+	// with a negative offset are not written.
+	struct VertexLayout
+	{
+		uint32 m_stride = 0;
+
+		int m_positionOffset = -1;
+		int m_normalOffset = -1;
+		int m_tangentUOffset = -1;
+		int m_texCOffset = -1;
+
+		// Constant colour written to every vertex, for layouts with a colour slot.
+		int m_colorOffset = -1;
+		DirectX::XMFLOAT4 m_color = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	};
+
+	// Order in which CreateGrid and CreateGridTiles emit quads.  Vertices are numbered by
+	// first use, so neighbouring quads share nearby vertices along the curve orders,
+	// where row-major order puts the next row n vertices away.
+	enum class GridOrder
+	{
+		RowMajor,
+		Morton,
+		Hilbert
+	};
+
+	// Vertex attributes compared by Weld, combined into a mask.
+	enum WeldAttribute : uint32
+	{
+		WeldPosition = 1 << 0,
+		WeldNormal = 1 << 1,
+		WeldTangentU = 1 << 2,
+		WeldTexC = 1 << 3,
+		WeldAll = WeldPosition | WeldNormal | WeldTangentU | WeldTexC
+	};
+
+	// Fractal noise (fBm) over 2D gradient noise, for CreateTerrainTiles.
+	struct TerrainNoise
+	{
+		uint32 m_seed = 0;
+		uint32 m_octaves = 6;
+
+		// Frequency of the first octave in cycles per world unit, and its height.
+		float m_frequency = 0.02f;
+		float m_amplitude = 8.0f;
+
+		// Frequency and amplitude of each octave relative to the one before.
+		float m_lacunarity = 2.0f;
+		float m_gain = 0.5f;
+	};
+
+	// How finely the CreateSphere, CreateGeosphere and CreateCylinder overloads taking a
+	// target tessellate.  They pick the fewest triangles keeping every point of the mesh
+	// within m_maxError of the true surface, but never more than m_triangleBudget.
+	struct TessellationTarget
+	{
+		// In world units, or in pixels when m_pixelsPerUnit is set.
+		float m_maxError = 0.01f;
+
+		// Pixels covered by one world unit at the shape's distance, for a screen-space
+		// error: viewportHeight / (2 * tan(fovY / 2) * distance).  Zero for world units.
+		float m_pixelsPerUnit = 0.0f;
+
+		// Zero for no limit.  The coarsest tessellation of a shape is used even if it is over.
+		uint32 m_triangleBudget = 0;
+	};
+
+	// A mesh tessellated from a TessellationTarget, with the parameters chosen for it and the
+	// error they achieve: the largest distance between the mesh and the true surface.
+	struct TessellatedMesh
+	{
+		MeshData m_meshData;
+
+		float m_chordalError = 0.0f;
+
+		// m_chordalError in pixels, or zero for a target in world units.
+		float m_screenError = 0.0f;
+
+		uint32 m_sliceCount = 0;
+		uint32 m_stackCount = 0;
+		uint32 m_numSubdivisions = 0;
+	};
+
+	// A range of a partitioned mesh whose indices are relative to its base vertex,
+	// matching the DrawIndexedInstanced parameters stored in a SubmeshGeometry.
+	struct IndexPartition
+	{
+		uint32 m_indexCount = 0;
+		uint32 m_startIndexLocation = 0;
+		int m_baseVertexLocation = 0;
+		uint32 m_vertexCount = 0;
+	};
+
+	/// Changes whenever any function here changes the meshes it makes for the same
+	/// arguments.  Hash it into cache keys of generated geometry, and bump it in the same
+	/// change as the code whose output it describes.
+	static constexpr uint32 s_outputVersion = 1;
+
+	GeometryGenerator() = default;
+
+	/// Allocates the generated meshes and the scratch space used to build them from
+	/// resource, for example a std::pmr::monotonic_buffer_resource holding a whole scene.
+	/// The resource is only used from the calling thread, so it need not be thread safe.
+	/// Everything the Create functions, Weld, OptimizeVertexCache, BuildLodChain and the
+	/// other mesh passes allocate comes from it, except for what stays on the heap: the
+	/// tile lists of CreateGridTiles and CreateTerrainTiles and the scratch their worker
+	/// threads allocate for themselves, MeshletData, the packing functions' outputs and
+	/// ParallelFor's threads.
+	explicit GeometryGenerator(std::pmr::memory_resource* resource);
+
 	/// Creates an mxn grid in the xz-plane with m rows and n columns, centered
-	/// at the origin with the specified width and depth.
-	MeshData CreateGrid(float width, float depth, uint32 m, uint32 n);
+	/// at the origin with the specified width and depth.  The Morton and Hilbert orders
+	/// emit the quads along a space filling curve and number the vertices to match, which
+	/// keeps the post-transform cache warm without running OptimizeVertexCache.
+	MeshData CreateGrid(float width, float depth, uint32 m, uint32 n, GridOrder order = GridOrder::RowMajor);
+
+	/// Creates the same grid as CreateGrid split into tiles of at most tileQuads x tileQuads
+	/// quads.  Each tile is a self-contained mesh in row-major tile order, so tiles can be
+	/// uploaded and drawn independently.  order applies within each tile.
+	std::vector<MeshData> CreateGridTiles(float width, float depth, uint32 m, uint32 n, uint32 tileQuads,
+		GridOrder order = GridOrder::RowMajor);
+
+	/// Creates the tiles of CreateGridTiles raised into terrain by fractal noise.  The noise is
+	/// evaluated four vertices at a time on all cores, and the normals and tangents come from
+	/// its analytic derivatives.  Each tile has a skirt hanging skirtDepth below its border to
+	/// hide the cracks between neighbouring tiles drawn at different levels of detail.
+	std::vector<MeshData> CreateTerrainTiles(float width, float depth, uint32 m, uint32 n, uint32 tileQuads,
+		const TerrainNoise& noise, float skirtDepth);
+
+	/// Creates terrain tiles like the overload above from an mxn heightmap with one sample per
+	/// grid vertex, in CreateGrid's vertex order, scaled by heightScale.  The normals come
+	/// from central differences of the heightmap.
+	std::vector<MeshData> CreateTerrainTiles(float width, float depth, uint32 m, uint32 n, uint32 tileQuads,
+		const float* heights, float heightScale, float skirtDepth);
 
 	/// Creates a box centered at the origin with the given dimensions, where each
 	/// face has m rows and n columns of vertices.
@@ -66,21 +343,208 @@ public:
 	/// slices and stacks parameters control the degree of tessellation.
 	MeshData CreateSphere(float radius, uint32 sliceCount, uint32 stackCount);
 
+	/// Creates a sphere with the fewest slices and stacks that meet target.  The error is
+	/// measured from the triangles the slices and stacks produce, not estimated.
+	TessellatedMesh CreateSphere(float radius, const TessellationTarget& target);
+
 	/// Creates a geosphere centered at the origin with the given radius.  The
-	/// depth controls the level of tessellation.
+	/// depth controls the level of tessellation.  Each level is subdivided once per
+	/// process and cached as a unit sphere, so later calls only scale the cached copy.
 	MeshData CreateGeosphere(float radius, uint32 numSubdivisions);
 
+	/// Creates a geosphere with the fewest subdivisions that meet target, measuring the
+	/// error of each cached level it tries.
+	TessellatedMesh CreateGeosphere(float radius, const TessellationTarget& target);
+
+	/// Returns the cached unit geosphere of the given level as a flat blob that can be
+	/// written to disk or embedded in the executable and handed to LoadGeosphereTopology.
+	std::vector<std::uint8_t> SerializeGeosphereTopology(uint32 numSubdivisions);
+
+	/// Seeds the geosphere cache from a blob made by SerializeGeosphereTopology, such as a
+	/// mapped file.  The blob is used in place, not copied, so it must be 4 byte aligned
+	/// and stay valid for the rest of the process.  Returns false if the blob is malformed
+	/// or its level is already cached.
+	bool LoadGeosphereTopology(const void* data, size_t size);
+
 	/// Creates an mxn grid in the xz-plane with m rows and n columns, centered
 	/// at the origin with the specified width and depth.
 	MeshData CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount);
 
+	/// Creates a cylinder with the fewest slices that meet target, and a single stack since
+	/// more stacks do not bring the sides any closer to the true surface.
+	TessellatedMesh CreateCylinder(float bottomRadius, float topRadius, float height, const TessellationTarget& target);
+
 	/// Creates a quad aligned with the screen.  This is useful for postprocessing and screen effects.
 	MeshData CreateQuad(float x, float y, float w, float h, float depth);
 
+	/// Builds progressively simplified versions of a mesh using quadric error edge collapse.
+	/// targets are the fractions of the input triangle count to keep, from finest to coarsest.
+	/// The first mesh returned is the input with its vertices reordered, followed by one mesh
+	/// per target.  Each level only uses a prefix of the first mesh's vertices, so every level
+	/// can be drawn from one vertex buffer and only the index lists need to be appended.
+	/// Vertices on open borders and texture seams are never collapsed.
+	std::pmr::vector<MeshData> BuildLodChain(const MeshData& meshData, const std::vector<float>& targets);
+
+	/// Partitions the triangles of a mesh, in index order, into meshlets of at most
+	/// maxVertices vertices and maxPrimitives triangles, each with a bounding sphere and a
+	/// normal cone for cluster culling.  Run OptimizeVertexCache first for tighter clusters.
+	MeshletData BuildMeshlets(const MeshData& meshData, uint32 maxVertices = 64, uint32 maxPrimitives = 124);
+
+	/// Recomputes the bounding box and bounding sphere of the mesh from its vertex positions.
+	void ComputeBounds(MeshData& meshData);
+
+	/// Recomputes the normal and tangent of every vertex from the triangles using it: the
+	/// area weighted sum of the face normals, and the direction of increasing u on each face
+	/// made orthogonal to the normal (Gram-Schmidt).  Vertices no triangle uses keep their
+	/// normal, and vertices without a usable texture mapping get an arbitrary tangent.
+	/// Runs on all cores, and the result does not depend on how many there are.
+	void ComputeNormalsAndTangents(MeshData& meshData);
+
+	/// Writes the requested attributes of each vertex into dest using the given layout.
+	/// dest must hold m_vertices.size() * layout.m_stride bytes and can be mapped upload
+	/// memory; it is only written to, front to back.
+	void WriteVertices(const MeshData& meshData, const VertexLayout& layout, void* dest);
+
+	/// Merges vertices whose attributes in attributeMask all lie within epsilon of each other,
+	/// component by component, and remaps the indices.  Positions are always compared.
+	/// Vertices are hashed by position into cells four times epsilon wide, so the pass runs
+	/// in linear time.  The kept vertices stay in their original order and are the first of
+	/// each group, so their other attributes come from it.  Returns the new vertex count.
+	/// Welding on WeldPosition alone gives the smallest mesh for depth-only and shadow passes.
+	uint32 Weld(MeshData& meshData, float epsilon = 0.0f, uint32 attributeMask = WeldAll);
+
+	/// Reorders the triangles for the post-transform vertex cache (Tipsify) and then
+	/// reorders the vertices to match their first use by the new index order.  Returns
+	/// the cache statistics before and after for a FIFO cache of the given size.
+	VertexCacheReport OptimizeVertexCache(MeshData& meshData, uint32 cacheSize = 16);
+
+	/// Packs the vertices of a mesh into PackedVertex form.  Zero length normals and tangents
+	/// do not survive the octahedral encoding and unpack as +z.
+	PackedMeshData PackVertices(const MeshData& meshData);
+
+	/// Expands packed vertices back to full precision, as the vertex shader would.
+	void UnpackVertices(const PackedMeshData& packedData, std::vector<Vertex>& vertices);
+
+	/// Compares a mesh's vertices with their packed versions.
+	PackingError MeasurePackingError(const MeshData& meshData, const PackedMeshData& packedData);
+
+	/// Simulates a FIFO post-transform cache of the given size over the index list.
+	VertexCacheStats AnalyzeVertexCache(const MeshData& meshData, uint32 cacheSize = 16);
+
+	/// Splits a mesh into consecutive triangle ranges that each reference at most 65536
+	/// vertices, so every range can be drawn with 16-bit indices and its own base vertex.
+	/// Vertices shared by two ranges are duplicated.  Returns false and leaves the mesh
+	/// untouched, with a single partition covering it, if the duplicated vertices (at the
+	/// given stride) would cost more memory than 16-bit indices save; draw it with 32-bit
+	/// indices instead.  Run OptimizeVertexCache first to keep the ranges compact.
+	bool PartitionIndices16(MeshData& meshData, std::vector<IndexPartition>& partitions,
+		uint32 vertexByteStride = sizeof(Vertex));
+
 private:
 
 	void Subdivide(MeshData& meshData);
+	MeshData BuildUnitGeosphere(uint32 numSubdivisions);
+	void SimplifyIndices(const MeshData& meshData, std::pmr::vector<uint32>& indices, uint32 targetTriangleCount);
 	Vertex MidPoint(const Vertex& v0, const Vertex& v1);
-	void BuildCylinderTopCap(float topRadius, float height, uint32 sliceCount, MeshData& meshData);
-	void BuildCylinderBottomCap(float bottomRadius, float height, uint32 sliceCount, MeshData& meshData);
-};
\ No newline at end of file
+	void BuildSliceTable(uint32 sliceCount, std::pmr::vector<float>& cosTheta, std::pmr::vector<float>& sinTheta);
+	void BuildCylinderTopCap(float topRadius, float height, uint32 sliceCount,
+		const std::pmr::vector<float>& cosTheta, const std::pmr::vector<float>& sinTheta, MeshData& meshData);
+	void BuildCylinderBottomCap(float bottomRadius, float height, uint32 sliceCount,
+		const std::pmr::vector<float>& cosTheta, const std::pmr::vector<float>& sinTheta, MeshData& meshData);
+
+	std::pmr::memory_resource* m_resource = std::pmr::get_default_resource();
+};
+
+// Fixed primitives as compile-time tables.  They need no construction or allocation at
+// run time, so they can be copied straight into an upload buffer.  CreateBox, CreateQuad
+// and CreateGeosphere start from these.
+namespace GeometryTables
+{
+	// A 1x1x1 box centered at the origin, as CreateBox(1.0f, 1.0f, 1.0f, 0) makes it.
+	constexpr GeometryGenerator::Vertex s_unitBoxVertices[24] =
+	{
+		// Front face.
+		GeometryGenerator::Vertex(-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+		GeometryGenerator::Vertex(-0.5f, +0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+		GeometryGenerator::Vertex(+0.5f, +0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f),
+		GeometryGenerator::Vertex(+0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f),
+
+		// Back face.
+		GeometryGenerator::Vertex(-0.5f, -0.5f, +0.5f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f),
+		GeometryGenerator::Vertex(+0.5f, -0.5f, +0.5f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+		GeometryGenerator::Vertex(+0.5f, +0.5f, +0.5f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+		GeometryGenerator::Vertex(-0.5f, +0.5f, +0.5f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f),
+
+		// Top face.
+		GeometryGenerator::Vertex(-0.5f, +0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+		GeometryGenerator::Vertex(-0.5f, +0.5f, +0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+		GeometryGenerator::Vertex(+0.5f, +0.5f, +0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f),
+		GeometryGenerator::Vertex(+0.5f, +0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f),
+
+		// Bottom face.
+		GeometryGenerator::Vertex(-0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f),
+		GeometryGenerator::Vertex(+0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+		GeometryGenerator::Vertex(+0.5f, -0.5f, +0.5f, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+		GeometryGenerator::Vertex(-0.5f, -0.5f, +0.5f, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f),
+
+		// Left face.
+		GeometryGenerator::Vertex(-0.5f, -0.5f, +0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f),
+		GeometryGenerator::Vertex(-0.5f, +0.5f, +0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f),
+		GeometryGenerator::Vertex(-0.5f, +0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f),
+		GeometryGenerator::Vertex(-0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f),
+
+		// Right face.
+		GeometryGenerator::Vertex(+0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f),
+		GeometryGenerator::Vertex(+0.5f, +0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f),
+		GeometryGenerator::Vertex(+0.5f, +0.5f, +0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f),
+		GeometryGenerator::Vertex(+0.5f, -0.5f, +0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f)
+	};
+
+	constexpr uint16 s_boxIndices[36] =
+	{
+		0, 1, 2, 0, 2, 3,		// Front face.
+		4, 5, 6, 4, 6, 7,		// Back face.
+		8, 9, 10, 8, 10, 11,	// Top face.
+		12, 13, 14, 12, 14, 15,	// Bottom face.
+		16, 17, 18, 16, 18, 19,	// Left face.
+		20, 21, 22, 20, 22, 23	// Right face.
+	};
+
+	// A 1x1 quad at depth 0 with its top left corner at the origin, as
+	// CreateQuad(0.0f, 0.0f, 1.0f, 1.0f, 0.0f) makes it.
+	constexpr GeometryGenerator::Vertex s_unitQuadVertices[4] =
+	{
+		GeometryGenerator::Vertex(0.0f, -1.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+		GeometryGenerator::Vertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f),
+		GeometryGenerator::Vertex(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f),
+		GeometryGenerator::Vertex(1.0f, -1.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f)
+	};
+
+	constexpr uint16 s_quadIndices[6] =
+	{
+		0, 1, 2,
+		0, 2, 3
+	};
+
+	// The icosahedron that CreateGeosphere subdivides.  Its vertices lie on the unit sphere.
+	constexpr float s_icosahedronX = 0.525731f;
+	constexpr float s_icosahedronZ = 0.850651f;
+
+	constexpr DirectX::XMFLOAT3 s_icosahedronPositions[12] =
+	{
+		DirectX::XMFLOAT3(-s_icosahedronX, 0.0f, s_icosahedronZ), DirectX::XMFLOAT3(s_icosahedronX, 0.0f, s_icosahedronZ),
+		DirectX::XMFLOAT3(-s_icosahedronX, 0.0f, -s_icosahedronZ), DirectX::XMFLOAT3(s_icosahedronX, 0.0f, -s_icosahedronZ),
+		DirectX::XMFLOAT3(0.0f, s_icosahedronZ, s_icosahedronX), DirectX::XMFLOAT3(0.0f, s_icosahedronZ, -s_icosahedronX),
+		DirectX::XMFLOAT3(0.0f, -s_icosahedronZ, s_icosahedronX), DirectX::XMFLOAT3(0.0f, -s_icosahedronZ, -s_icosahedronX),
+		DirectX::XMFLOAT3(s_icosahedronZ, s_icosahedronX, 0.0f), DirectX::XMFLOAT3(-s_icosahedronZ, s_icosahedronX, 0.0f),
+		DirectX::XMFLOAT3(s_icosahedronZ, -s_icosahedronX, 0.0f), DirectX::XMFLOAT3(-s_icosahedronZ, -s_icosahedronX, 0.0f)
+	};
+
+	constexpr uint16 s_icosahedronIndices[60] =
+	{
+		1,4,0, 4,9,0, 4,5,9, 8,5,4, 1,8,4,
+		1,10,8, 10,3,8, 8,3,5, 3,2,5, 3,7,2,
+		3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0,
+		10,1,6, 11,0,9, 2,11,9, 5,2,9, 11,2,7
+	};
+}
@@ -4,13 +4,726 @@
 
 #include "MathHelper.h"
 #include <float.h>
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstring>
+#include <mutex>
+
+#if defined(_XM_SSE_INTRINSICS_)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// The AVX2 and AVX-512 kernels are compiled into every build and only called on CPUs
+// that have them.  GCC and Clang need to be told which instructions each may use.
+#if defined(__GNUC__)
+#define MATHHELPER_AVX2_TARGET __attribute__((target("avx2,fma")))
+#define MATHHELPER_AVX512_TARGET __attribute__((target("avx512f")))
+#else
+#define MATHHELPER_AVX2_TARGET
+#define MATHHELPER_AVX512_TARGET
+#endif
+#endif
 
 using namespace DirectX;
 
 const float MathHelper::Infinity = FLT_MAX;
 const float MathHelper::Pi       = 3.1415926535f;
 
+namespace
+{
+	// Jump polynomials of xoshiro256, advancing the state by 2^128 and 2^192 draws.
+	const std::uint64_t s_jump[4] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c };
+	const std::uint64_t s_longJump[4] = { 0x76e15d3efefdcbbf, 0xc5004e441c522fb3, 0x77710069854ee241, 0x39109bb02acbe635 };
+
+	const float s_unitFloatScale = 1.0f / 16777216.0f;
+
+	std::uint64_t RotateLeft(std::uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+
+	std::uint64_t SplitMix64(std::uint64_t& x)
+	{
+		std::uint64_t z = (x += 0x9e3779b97f4a7c15);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+		return z ^ (z >> 31);
+	}
+
+	// A count of SeedRandom calls, so the threads notice the seed changed without locking.
+	std::atomic<std::uint32_t> s_randomSeedVersion{ 0 };
+
+	// Hands out the threads' streams.  A thread takes a copy of the master and the master
+	// is long-jumped past it, so each new stream costs one jump however many threads came
+	// before it.
+	struct RandomStreamSource
+	{
+		std::mutex m_mutex;
+		RandomGenerator m_master;
+	};
+
+	RandomStreamSource& GetRandomStreamSource()
+	{
+		static RandomStreamSource source;
+		return source;
+	}
+
+	struct ThreadRandomState
+	{
+		RandomGenerator m_generator;
+		std::uint32_t m_seedVersion = 0xffffffff;
+	};
+
+	// Directions are made in chunks from a buffer of uniform numbers on the stack.  A
+	// multiple of four, so every chunk but the last fills whole vectors.
+	const std::uint32_t s_directionChunk = 64;
+
+	std::uint32_t ReverseBits(std::uint32_t x)
+	{
+		x = (x << 16) | (x >> 16);
+		x = ((x & 0x00ff00ff) << 8) | ((x & 0xff00ff00) >> 8);
+		x = ((x & 0x0f0f0f0f) << 4) | ((x & 0xf0f0f0f0) >> 4);
+		x = ((x & 0x33333333) << 2) | ((x & 0xcccccccc) >> 2);
+		x = ((x & 0x55555555) << 1) | ((x & 0xaaaaaaaa) >> 1);
+		return x;
+	}
+
+	// The rows of a matrix used by the batch transforms: out = x*m[0] + y*m[1] + z*m[2] + m[3],
+	// with m[3] zero for normals.
+	struct TransformRows
+	{
+		float m[4][3];
+	};
+
+	TransformRows GetTransformRows(CXMMATRIX M, bool translate)
+	{
+		XMFLOAT4X4 matrix;
+		XMStoreFloat4x4(&matrix, M);
+
+		TransformRows rows;
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+				rows.m[i][j] = (i < 3 || translate) ? matrix.m[i][j] : 0.0f;
+		}
+
+		return rows;
+	}
+
+	void TransformPoint(const TransformRows& rows, float x, float y, float z, float* out)
+	{
+		for (int j = 0; j < 3; ++j)
+			out[j] = x * rows.m[0][j] + y * rows.m[1][j] + z * rows.m[2][j] + rows.m[3][j];
+	}
+
+	void TransformSoAScalar(const TransformRows& rows, const float* x, const float* y, const float* z,
+		float* destX, float* destY, float* destZ, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			float out[3];
+			TransformPoint(rows, x[i], y[i], z[i], out);
+
+			destX[i] = out[0];
+			destY[i] = out[1];
+			destZ[i] = out[2];
+		}
+	}
+
+	// Sets head to the number of elements to transform one at a time before the outputs
+	// reach the given alignment.  Returns false if they cannot all get there together.
+	bool AlignedHead(const float* destX, const float* destY, const float* destZ, size_t alignment, size_t count,
+		size_t& head)
+	{
+		std::uintptr_t offset = reinterpret_cast<std::uintptr_t>(destX) & (alignment - 1);
+		if ((offset & 3) != 0 ||
+			(reinterpret_cast<std::uintptr_t>(destY) & (alignment - 1)) != offset ||
+			(reinterpret_cast<std::uintptr_t>(destZ) & (alignment - 1)) != offset)
+			return false;
+
+		head = std::min<size_t>(((alignment - offset) & (alignment - 1)) / sizeof(float), count);
+		return true;
+	}
+
+	using TransformSoAKernel = void (*)(const TransformRows& rows, const float* x, const float* y, const float* z,
+		float* destX, float* destY, float* destZ, size_t count, TransformStore store);
+
+	void TransformSoAPortable(const TransformRows& rows, const float* x, const float* y, const float* z,
+		float* destX, float* destY, float* destZ, size_t count, TransformStore)
+	{
+		TransformSoAScalar(rows, x, y, z, destX, destY, destZ, 0, count);
+	}
+
+#if defined(_XM_SSE_INTRINSICS_)
+	// The SIMD kernels all follow the same pattern: broadcast the rows, peel single
+	// elements until the outputs are aligned if streaming, then run whole vectors and
+	// finish the remainder one at a time.  Outputs that cannot be aligned together get
+	// ordinary unaligned stores rather than the scalar loop.  The SSE kernels add in the
+	// same order as TransformPoint, so they match it exactly; the FMA kernels round once less.
+	void TransformSoASse(const TransformRows& rows, const float* x, const float* y, const float* z,
+		float* destX, float* destY, float* destZ, size_t count, TransformStore store)
+	{
+		__m128 m[4][3];
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+				m[i][j] = _mm_set1_ps(rows.m[i][j]);
+		}
+
+		size_t first = 0;
+		bool stream = store == TransformStore::Streaming && AlignedHead(destX, destY, destZ, 16, count, first);
+		TransformSoAScalar(rows, x, y, z, destX, destY, destZ, 0, first);
+
+		float* dest[3] = { destX, destY, destZ };
+
+		size_t i = first;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 vx = _mm_loadu_ps(x + i);
+			__m128 vy = _mm_loadu_ps(y + i);
+			__m128 vz = _mm_loadu_ps(z + i);
+
+			for (int j = 0; j < 3; ++j)
+			{
+				__m128 out = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m[0][j]), _mm_mul_ps(vy, m[1][j])),
+					_mm_mul_ps(vz, m[2][j])), m[3][j]);
+
+				if (stream)
+					_mm_stream_ps(dest[j] + i, out);
+				else
+					_mm_storeu_ps(dest[j] + i, out);
+			}
+		}
+
+		TransformSoAScalar(rows, x, y, z, destX, destY, destZ, i, count);
+
+		if (stream)
+			_mm_sfence();
+	}
+
+	MATHHELPER_AVX2_TARGET void TransformSoAAvx2(const TransformRows& rows, const float* x, const float* y, const float* z,
+		float* destX, float* destY, float* destZ, size_t count, TransformStore store)
+	{
+		__m256 m[4][3];
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+				m[i][j] = _mm256_set1_ps(rows.m[i][j]);
+		}
+
+		size_t first = 0;
+		bool stream = store == TransformStore::Streaming && AlignedHead(destX, destY, destZ, 32, count, first);
+		TransformSoAScalar(rows, x, y, z, destX, destY, destZ, 0, first);
+
+		float* dest[3] = { destX, destY, destZ };
+
+		size_t i = first;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 vx = _mm256_loadu_ps(x + i);
+			__m256 vy = _mm256_loadu_ps(y + i);
+			__m256 vz = _mm256_loadu_ps(z + i);
+
+			for (int j = 0; j < 3; ++j)
+			{
+				__m256 out = _mm256_fmadd_ps(vx, m[0][j], _mm256_fmadd_ps(vy, m[1][j], _mm256_fmadd_ps(vz, m[2][j], m[3][j])));
+
+				if (stream)
+					_mm256_stream_ps(dest[j] + i, out);
+				else
+					_mm256_storeu_ps(dest[j] + i, out);
+			}
+		}
+
+		TransformSoAScalar(rows, x, y, z, destX, destY, destZ, i, count);
+
+		if (stream)
+			_mm_sfence();
+	}
+
+	MATHHELPER_AVX512_TARGET void TransformSoAAvx512(const TransformRows& rows, const float* x, const float* y, const float* z,
+		float* destX, float* destY, float* destZ, size_t count, TransformStore store)
+	{
+		__m512 m[4][3];
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+				m[i][j] = _mm512_set1_ps(rows.m[i][j]);
+		}
+
+		size_t first = 0;
+		bool stream = store == TransformStore::Streaming && AlignedHead(destX, destY, destZ, 64, count, first);
+		TransformSoAScalar(rows, x, y, z, destX, destY, destZ, 0, first);
+
+		float* dest[3] = { destX, destY, destZ };
+
+		size_t i = first;
+		for (; i + 16 <= count; i += 16)
+		{
+			__m512 vx = _mm512_loadu_ps(x + i);
+			__m512 vy = _mm512_loadu_ps(y + i);
+			__m512 vz = _mm512_loadu_ps(z + i);
+
+			for (int j = 0; j < 3; ++j)
+			{
+				__m512 out = _mm512_fmadd_ps(vx, m[0][j], _mm512_fmadd_ps(vy, m[1][j], _mm512_fmadd_ps(vz, m[2][j], m[3][j])));
+
+				if (stream)
+					_mm512_stream_ps(dest[j] + i, out);
+				else
+					_mm512_storeu_ps(dest[j] + i, out);
+			}
+		}
+
+		TransformSoAScalar(rows, x, y, z, destX, destY, destZ, i, count);
+
+		if (stream)
+			_mm_sfence();
+	}
+
+	// CPUID reports what the CPU can do and XGETBV whether the OS saves the wider registers.
+	bool CpuHasAvx2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+
+		__cpuid(info, 1);
+		const int fma = 1 << 12, osxsave = 1 << 27, avx = 1 << 28;
+		if ((info[2] & (fma | osxsave | avx)) != (fma | osxsave | avx) || (_xgetbv(0) & 0x6) != 0x6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+
+	bool CpuHasAvx512()
+	{
+#if defined(_MSC_VER)
+		if (!CpuHasAvx2())
+			return false;
+
+		int info[4];
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 16)) != 0 && (_xgetbv(0) & 0xe6) == 0xe6;
+#else
+		return __builtin_cpu_supports("avx512f");
+#endif
+	}
+#endif
+
+	TransformSoAKernel SelectTransformSoAKernel()
+	{
+#if defined(_XM_SSE_INTRINSICS_)
+		if (CpuHasAvx512())
+			return TransformSoAAvx512;
+		if (CpuHasAvx2())
+			return TransformSoAAvx2;
+		return TransformSoASse;
+#else
+		return TransformSoAPortable;
+#endif
+	}
+
+	// Transforms an array of XMFLOAT3s.  Packed arrays are read and written as three
+	// vectors per four points, shuffled to and from one vector per component.
+	void TransformStream(XMFLOAT3* dest, size_t destStride, const XMFLOAT3* src, size_t srcStride,
+		size_t count, const TransformRows& rows, TransformStore store)
+	{
+		size_t i = 0;
+
+#if defined(_XM_SSE_INTRINSICS_)
+		if (destStride == sizeof(XMFLOAT3) && srcStride == sizeof(XMFLOAT3))
+		{
+			const float* in = &src->x;
+			float* out = &dest->x;
+
+			// A group of four points is 48 bytes, so once one group starts on a 16 byte
+			// boundary they all do.
+			bool stream = false;
+			if (store == TransformStore::Streaming && (reinterpret_cast<std::uintptr_t>(out) & 3) == 0)
+			{
+				for (; i < count && (reinterpret_cast<std::uintptr_t>(out + 3 * i) & 15) != 0; ++i)
+					TransformPoint(rows, in[3 * i], in[3 * i + 1], in[3 * i + 2], out + 3 * i);
+
+				stream = true;
+			}
+
+			__m128 m[4][3];
+			for (int r = 0; r < 4; ++r)
+			{
+				for (int j = 0; j < 3; ++j)
+					m[r][j] = _mm_set1_ps(rows.m[r][j]);
+			}
+
+			for (; i + 4 <= count; i += 4)
+			{
+				// a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3.
+				__m128 a = _mm_loadu_ps(in + 3 * i);
+				__m128 b = _mm_loadu_ps(in + 3 * i + 4);
+				__m128 c = _mm_loadu_ps(in + 3 * i + 8);
+
+				__m128 vx = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+				__m128 vy = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+					_mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+				__m128 vz = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+
+				__m128 v[3];
+				for (int j = 0; j < 3; ++j)
+				{
+					v[j] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m[0][j]), _mm_mul_ps(vy, m[1][j])),
+						_mm_mul_ps(vz, m[2][j])), m[3][j]);
+				}
+
+				// And back to x0 y0 z0 x1, y1 z1 x2 y2, z2 x3 y3 z3.
+				a = _mm_shuffle_ps(_mm_shuffle_ps(v[0], v[1], _MM_SHUFFLE(0, 0, 0, 0)),
+					_mm_shuffle_ps(v[2], v[0], _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+				b = _mm_shuffle_ps(_mm_shuffle_ps(v[1], v[2], _MM_SHUFFLE(1, 1, 1, 1)),
+					_mm_shuffle_ps(v[0], v[1], _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+				c = _mm_shuffle_ps(_mm_shuffle_ps(v[2], v[0], _MM_SHUFFLE(3, 3, 2, 2)),
+					_mm_shuffle_ps(v[1], v[2], _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+
+				if (stream)
+				{
+					_mm_stream_ps(out + 3 * i, a);
+					_mm_stream_ps(out + 3 * i + 4, b);
+					_mm_stream_ps(out + 3 * i + 8, c);
+				}
+				else
+				{
+					_mm_storeu_ps(out + 3 * i, a);
+					_mm_storeu_ps(out + 3 * i + 4, b);
+					_mm_storeu_ps(out + 3 * i + 8, c);
+				}
+			}
+
+			if (stream)
+				_mm_sfence();
+		}
+#endif
+
+		const std::uint8_t* in = reinterpret_cast<const std::uint8_t*>(src);
+		std::uint8_t* out = reinterpret_cast<std::uint8_t*>(dest);
+
+		for (; i < count; ++i)
+		{
+			const XMFLOAT3& p = *reinterpret_cast<const XMFLOAT3*>(in + i * srcStride);
+			TransformPoint(rows, p.x, p.y, p.z, &reinterpret_cast<XMFLOAT3*>(out + i * destStride)->x);
+		}
+	}
+
+	// Turns pairs of numbers in [0, 1) into unit vectors, four at a time.  u1 sets the
+	// height along the axis and u2 the angle around it, which the distributions map so
+	// that equal areas of the unit square land on equal (or cosine weighted) areas of the
+	// sphere.  The vectors are then carried from +z onto n with the branchless
+	// orthonormal basis of Duff et al.  u1 and u2 are read in whole vectors of four, so
+	// they must be readable up to the next multiple of four.
+	void MapDirections(const float* u1, const float* u2, size_t count, DirectionDistribution distribution,
+		FXMVECTOR n, XMFLOAT3* dest)
+	{
+		XMFLOAT3 axis(0.0f, 0.0f, 1.0f);
+		XMFLOAT3 tangent(1.0f, 0.0f, 0.0f);
+		XMFLOAT3 bitangent(0.0f, 1.0f, 0.0f);
+
+		if (distribution != DirectionDistribution::Sphere)
+		{
+			XMStoreFloat3(&axis, n);
+
+			float sign = copysignf(1.0f, axis.z);
+			float a = -1.0f / (sign + axis.z);
+			float b = axis.x * axis.y * a;
+
+			tangent = XMFLOAT3(1.0f + sign * axis.x * axis.x * a, sign * b, -sign * axis.x);
+			bitangent = XMFLOAT3(b, sign + axis.y * axis.y * a, -axis.y);
+		}
+
+		const XMVECTOR one = XMVectorSplatOne();
+		const XMVECTOR zero = XMVectorZero();
+		const XMVECTOR twoPi = XMVectorReplicate(XM_2PI);
+
+		for (size_t i = 0; i < count; i += 4)
+		{
+			XMVECTOR h = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(u1 + i));
+			XMVECTOR phi = XMVectorMultiply(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(u2 + i)), twoPi);
+
+			XMVECTOR z, r;
+			switch (distribution)
+			{
+			case DirectionDistribution::Sphere:
+				z = XMVectorNegativeMultiplySubtract(XMVectorReplicate(2.0f), h, one);
+				r = XMVectorSqrt(XMVectorMax(XMVectorNegativeMultiplySubtract(z, z, one), zero));
+				break;
+
+			case DirectionDistribution::Hemisphere:
+				// 1 - u1 rather than u1, so no direction lies in the surface.
+				z = XMVectorSubtract(one, h);
+				r = XMVectorSqrt(XMVectorMax(XMVectorNegativeMultiplySubtract(z, z, one), zero));
+				break;
+
+			default:
+				r = XMVectorSqrt(h);
+				z = XMVectorSqrt(XMVectorSubtract(one, h));
+				break;
+			}
+
+			XMVECTOR sinPhi, cosPhi;
+			XMVectorSinCos(&sinPhi, &cosPhi, phi);
+
+			XMVECTOR x = XMVectorMultiply(r, cosPhi);
+			XMVECTOR y = XMVectorMultiply(r, sinPhi);
+
+			XMFLOAT4 outX, outY, outZ;
+			XMStoreFloat4(&outX, XMVectorMultiplyAdd(z, XMVectorReplicate(axis.x),
+				XMVectorMultiplyAdd(y, XMVectorReplicate(bitangent.x), XMVectorMultiply(x, XMVectorReplicate(tangent.x)))));
+			XMStoreFloat4(&outY, XMVectorMultiplyAdd(z, XMVectorReplicate(axis.y),
+				XMVectorMultiplyAdd(y, XMVectorReplicate(bitangent.y), XMVectorMultiply(x, XMVectorReplicate(tangent.y)))));
+			XMStoreFloat4(&outZ, XMVectorMultiplyAdd(z, XMVectorReplicate(axis.z),
+				XMVectorMultiplyAdd(y, XMVectorReplicate(bitangent.z), XMVectorMultiply(x, XMVectorReplicate(tangent.z)))));
+
+			size_t laneCount = std::min<size_t>(4, count - i);
+			for (size_t lane = 0; lane < laneCount; ++lane)
+				dest[i + lane] = XMFLOAT3((&outX.x)[lane], (&outY.x)[lane], (&outZ.x)[lane]);
+		}
+	}
+}
+
+RandomGenerator::RandomGenerator(std::uint64_t seed)
+{
+	Seed(seed);
+}
+
+void RandomGenerator::Seed(std::uint64_t seed)
+{
+	for (int k = 0; k < 4; ++k)
+	{
+		m_state[k][0] = SplitMix64(seed);
+		m_state[k][1] = m_state[k][0];
+	}
+
+	JumpLane(1, s_jump);
+}
+
+void RandomGenerator::LongJump()
+{
+	JumpLane(0, s_longJump);
+	JumpLane(1, s_longJump);
+}
+
+std::uint64_t RandomGenerator::NextU64()
+{
+	return NextLane(0);
+}
+
+int RandomGenerator::NextInt(int a, int b)
+{
+	// Scale a 32-bit draw into the range with a multiply, rejecting the few low products
+	// that would make some results more likely than others.  A range of 2^32 wraps to 0.
+	std::uint32_t range = (std::uint32_t)b - (std::uint32_t)a + 1;
+	if (range == 0)
+		return (int)NextU32();
+
+	std::uint64_t m = (std::uint64_t)NextU32() * range;
+	if ((std::uint32_t)m < range)
+	{
+		std::uint32_t threshold = (0u - range) % range;
+		while ((std::uint32_t)m < threshold)
+			m = (std::uint64_t)NextU32() * range;
+	}
+
+	return (int)((std::uint32_t)a + (std::uint32_t)(m >> 32));
+}
+
+std::uint64_t RandomGenerator::NextLane(int lane)
+{
+	std::uint64_t s0 = m_state[0][lane];
+	std::uint64_t s1 = m_state[1][lane];
+	std::uint64_t s2 = m_state[2][lane];
+	std::uint64_t s3 = m_state[3][lane];
+
+	std::uint64_t result = RotateLeft(s0 + s3, 23) + s0;
+	std::uint64_t t = s1 << 17;
+
+	s2 ^= s0;
+	s3 ^= s1;
+	s1 ^= s2;
+	s0 ^= s3;
+	s2 ^= t;
+	s3 = RotateLeft(s3, 45);
+
+	m_state[0][lane] = s0;
+	m_state[1][lane] = s1;
+	m_state[2][lane] = s2;
+	m_state[3][lane] = s3;
+
+	return result;
+}
+
+void RandomGenerator::JumpLane(int lane, const std::uint64_t (&polynomial)[4])
+{
+	std::uint64_t jumped[4] = { 0, 0, 0, 0 };
+
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int bit = 0; bit < 64; ++bit)
+		{
+			if (polynomial[i] & (std::uint64_t(1) << bit))
+			{
+				for (int k = 0; k < 4; ++k)
+					jumped[k] ^= m_state[k][lane];
+			}
+
+			NextLane(lane);
+		}
+	}
+
+	for (int k = 0; k < 4; ++k)
+		m_state[k][lane] = jumped[k];
+}
+
+template<typename Store>
+void RandomGenerator::GenerateBlocks(size_t blockCount, const Store& store)
+{
+#if defined(_XM_SSE_INTRINSICS_)
+	// The same steps as NextLane on both lanes at once.  SSE2 has no 64-bit rotate, so
+	// rotates are a pair of shifts.
+	__m128i s0 = _mm_load_si128(reinterpret_cast<const __m128i*>(m_state[0]));
+	__m128i s1 = _mm_load_si128(reinterpret_cast<const __m128i*>(m_state[1]));
+	__m128i s2 = _mm_load_si128(reinterpret_cast<const __m128i*>(m_state[2]));
+	__m128i s3 = _mm_load_si128(reinterpret_cast<const __m128i*>(m_state[3]));
+
+	const __m128 unitScale = _mm_set1_ps(s_unitFloatScale);
+
+	for (size_t i = 0; i < blockCount; ++i)
+	{
+		__m128i sum = _mm_add_epi64(s0, s3);
+		__m128i result = _mm_add_epi64(_mm_or_si128(_mm_slli_epi64(sum, 23), _mm_srli_epi64(sum, 41)), s0);
+		__m128i t = _mm_slli_epi64(s1, 17);
+
+		s2 = _mm_xor_si128(s2, s0);
+		s3 = _mm_xor_si128(s3, s1);
+		s1 = _mm_xor_si128(s1, s2);
+		s0 = _mm_xor_si128(s0, s3);
+		s2 = _mm_xor_si128(s2, t);
+		s3 = _mm_or_si128(_mm_slli_epi64(s3, 45), _mm_srli_epi64(s3, 19));
+
+		// The top 24 bits of each 32-bit half convert to float exactly.
+		store(i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(result, 8)), unitScale));
+	}
+
+	_mm_store_si128(reinterpret_cast<__m128i*>(m_state[0]), s0);
+	_mm_store_si128(reinterpret_cast<__m128i*>(m_state[1]), s1);
+	_mm_store_si128(reinterpret_cast<__m128i*>(m_state[2]), s2);
+	_mm_store_si128(reinterpret_cast<__m128i*>(m_state[3]), s3);
+#else
+	for (size_t i = 0; i < blockCount; ++i)
+	{
+		std::uint64_t r0 = NextLane(0);
+		std::uint64_t r1 = NextLane(1);
+
+		store(i, XMVectorSet(
+			(float)((std::uint32_t)r0 >> 8) * s_unitFloatScale,
+			(float)((std::uint32_t)(r0 >> 32) >> 8) * s_unitFloatScale,
+			(float)((std::uint32_t)r1 >> 8) * s_unitFloatScale,
+			(float)((std::uint32_t)(r1 >> 32) >> 8) * s_unitFloatScale));
+	}
+#endif
+}
+
+void RandomGenerator::FillFloats(float* dest, size_t count, float a, float b)
+{
+	XMVECTOR scale = XMVectorReplicate(b - a);
+	XMVECTOR offset = XMVectorReplicate(a);
+
+	size_t blockCount = count / 4;
+	GenerateBlocks(blockCount, [&](size_t i, FXMVECTOR unit)
+	{
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(dest + 4 * i), XMVectorMultiplyAdd(unit, scale, offset));
+	});
+
+	// The rest of the last block is thrown away.
+	size_t remainder = count % 4;
+	if (remainder > 0)
+	{
+		XMFLOAT4 last;
+		GenerateBlocks(1, [&](size_t, FXMVECTOR unit)
+		{
+			XMStoreFloat4(&last, XMVectorMultiplyAdd(unit, scale, offset));
+		});
+
+		std::memcpy(dest + 4 * blockCount, &last, remainder * sizeof(float));
+	}
+}
+
+void RandomGenerator::FillVectors(XMFLOAT3* dest, size_t count, FXMVECTOR a, FXMVECTOR b)
+{
+	XMVECTOR scale = XMVectorSubtract(b, a);
+
+	GenerateBlocks(count, [&](size_t i, FXMVECTOR unit)
+	{
+		XMStoreFloat3(&dest[i], XMVectorMultiplyAdd(unit, scale, a));
+	});
+}
+
+void RandomGenerator::FillVectors(XMFLOAT4* dest, size_t count, FXMVECTOR a, FXMVECTOR b)
+{
+	XMVECTOR scale = XMVectorSubtract(b, a);
+
+	GenerateBlocks(count, [&](size_t i, FXMVECTOR unit)
+	{
+		XMStoreFloat4(&dest[i], XMVectorMultiplyAdd(unit, scale, a));
+	});
+}
+
+void RandomGenerator::FillDirections(XMFLOAT3* dest, size_t count, DirectionDistribution distribution, FXMVECTOR n)
+{
+	// Each chunk draws all its heights and then all its angles, so the output only
+	// depends on the seed and count.
+	float u[2 * s_directionChunk + 4] = {};
+
+	for (size_t first = 0; first < count; first += s_directionChunk)
+	{
+		size_t chunk = std::min<size_t>(s_directionChunk, count - first);
+
+		FillFloats(u, 2 * chunk);
+		MapDirections(u, u + chunk, chunk, distribution, n, dest + first);
+	}
+}
+
+RandomGenerator& MathHelper::ThreadRandom()
+{
+	thread_local ThreadRandomState state;
+
+	if (state.m_seedVersion != s_randomSeedVersion.load(std::memory_order_relaxed))
+	{
+		RandomStreamSource& source = GetRandomStreamSource();
+		std::lock_guard<std::mutex> lock(source.m_mutex);
+
+		state.m_generator = source.m_master;
+		source.m_master.LongJump();
+
+		state.m_seedVersion = s_randomSeedVersion.load(std::memory_order_relaxed);
+	}
+
+	return state.m_generator;
+}
+
+void MathHelper::SeedRandom(std::uint64_t seed)
+{
+	RandomStreamSource& source = GetRandomStreamSource();
+	std::lock_guard<std::mutex> lock(source.m_mutex);
+
+	source.m_master.Seed(seed);
+	s_randomSeedVersion.fetch_add(1, std::memory_order_relaxed);
+}
+
 float MathHelper::AngleFromXY(float x, float y)
 {
 	float theta = 0.0f;
@@ -33,50 +746,187 @@ float MathHelper::AngleFromXY(float x, float y)
 	return theta;
 }
 
-XMVECTOR MathHelper::RandUnitVec3()
+namespace
 {
-	XMVECTOR One  = XMVectorSet(1.0f, 1.0f, 1.0f, 1.0f);
-	XMVECTOR Zero = XMVectorZero();
-
-	// Keep trying until we get a point on/in the hemisphere.
-	while(true)
+	// Completes the inverse of an affine matrix from the inverse of its 3x3 part: the
+	// translation t is undone by -t * inverse3x3.
+	XMMATRIX SetInverseTranslation(XMMATRIX inverse, FXMVECTOR t)
 	{
-		// Generate random point in the cube [-1,1]^3.
-		XMVECTOR v = XMVectorSet(MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), 0.0f);
+		XMVECTOR moved = XMVectorMultiplyAdd(XMVectorSplatZ(t), inverse.r[2],
+			XMVectorMultiplyAdd(XMVectorSplatY(t), inverse.r[1], XMVectorMultiply(XMVectorSplatX(t), inverse.r[0])));
 
-		// Ignore points outside the unit sphere in order to get an even distribution
-		// over the unit sphere.  Otherwise points will clump more on the sphere near
-		// the corners of the cube.
+		inverse.r[3] = XMVectorSubtract(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSetW(moved, 0.0f));
+		return inverse;
+	}
+}
 
-		if( XMVector3Greater( XMVector3LengthSq(v), One) )
-			continue;
+XMMATRIX MathHelper::InverseRigid(CXMMATRIX M)
+{
+	XMMATRIX rotation = M;
+	rotation.r[3] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
 
-		return XMVector3Normalize(v);
-	}
+	return SetInverseTranslation(XMMatrixTranspose(rotation), M.r[3]);
+}
+
+XMMATRIX MathHelper::InverseAffine(CXMMATRIX M)
+{
+	return SetInverseTranslation(XMMatrixTranspose(InverseTransposeAffine(M)), M.r[3]);
+}
+
+XMMATRIX MathHelper::InverseTransposeAffine(CXMMATRIX M)
+{
+	// With rows r0, r1 and r2, the columns of the inverse are r1 x r2, r2 x r0 and
+	// r0 x r1 over the determinant, so those are the rows of the inverse transpose.
+	XMVECTOR c0 = XMVector3Cross(M.r[1], M.r[2]);
+	XMVECTOR c1 = XMVector3Cross(M.r[2], M.r[0]);
+	XMVECTOR c2 = XMVector3Cross(M.r[0], M.r[1]);
+
+	XMVECTOR invDet = XMVectorReciprocal(XMVector3Dot(M.r[0], c0));
+
+	XMMATRIX result;
+	result.r[0] = XMVectorSetW(XMVectorMultiply(c0, invDet), 0.0f);
+	result.r[1] = XMVectorSetW(XMVectorMultiply(c1, invDet), 0.0f);
+	result.r[2] = XMVectorSetW(XMVectorMultiply(c2, invDet), 0.0f);
+	result.r[3] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+
+	return result;
+}
+
+XMMATRIX MathHelper::InversePerspective(CXMMATRIX P)
+{
+	// A perspective projection maps (x, y, z, w) to
+	//   (x*_11 + z*_31, y*_22 + z*_32, z*_33 + w*_43, z*_34),
+	// which can be solved for x, y, z and w one after the other.
+	XMFLOAT4X4 p;
+	XMStoreFloat4x4(&p, P);
+
+	float invW = 1.0f / p._34;
+
+	XMFLOAT4X4 inverse(
+		1.0f / p._11, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f / p._22, 0.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f / p._43,
+		-p._31 * invW / p._11, -p._32 * invW / p._22, invW, -p._33 * invW / p._43);
+
+	return XMLoadFloat4x4(&inverse);
+}
+
+XMVECTOR MathHelper::RandUnitVec3()
+{
+	// A height uniform in [-1, 1] and an angle uniform around the axis give a point
+	// uniform over the sphere (Archimedes' hat-box theorem), so nothing is rejected.
+	RandomGenerator& random = ThreadRandom();
+
+	float z = 1.0f - 2.0f * random.NextFloat();
+	float r = sqrtf(std::max(0.0f, 1.0f - z*z));
+	float phi = 2.0f*Pi*random.NextFloat();
+
+	return XMVectorSet(r*cosf(phi), r*sinf(phi), z, 0.0f);
 }
 
 XMVECTOR MathHelper::RandHemisphereUnitVec3(XMVECTOR n)
 {
-	XMVECTOR One  = XMVectorSet(1.0f, 1.0f, 1.0f, 1.0f);
-	XMVECTOR Zero = XMVectorZero();
+	// Mirroring the bottom half of the sphere onto the top keeps the distribution uniform.
+	XMVECTOR v = RandUnitVec3();
+
+	if( XMVector3Less( XMVector3Dot(n, v), XMVectorZero() ) )
+		v = XMVectorNegate(v);
+
+	return v;
+}
+
+void MathHelper::HammersleyDirections(XMFLOAT3* dest, std::uint32_t count, DirectionDistribution distribution,
+	FXMVECTOR n, std::uint32_t scramble)
+{
+	// Point i of the set is ((i + 0.5) / count, the base 2 radical inverse of i).  XORing
+	// the radical inverse with scramble permutes its digits without disturbing the strata.
+	float u1[s_directionChunk];
+	float u2[s_directionChunk];
 
-	// Keep trying until we get a point on/in the hemisphere.
-	while(true)
+	for (std::uint32_t first = 0; first < count; first += s_directionChunk)
 	{
-		// Generate random point in the cube [-1,1]^3.
-		XMVECTOR v = XMVectorSet(MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), 0.0f);
+		std::uint32_t chunk = std::min(s_directionChunk, count - first);
+
+		for (std::uint32_t i = 0; i < s_directionChunk; ++i)
+		{
+			u1[i] = ((float)(first + i) + 0.5f) / (float)count;
+			u2[i] = (float)((ReverseBits(first + i) ^ scramble) >> 8) * s_unitFloatScale;
+		}
+
+		MapDirections(u1, u2, chunk, distribution, n, dest + first);
+	}
+}
+
+void MathHelper::TransformPoints(XMFLOAT3* dest, size_t destStride, const XMFLOAT3* src, size_t srcStride,
+	size_t count, CXMMATRIX M, TransformStore store)
+{
+	TransformStream(dest, destStride, src, srcStride, count, GetTransformRows(M, true), store);
+}
+
+void MathHelper::TransformNormals(XMFLOAT3* dest, size_t destStride, const XMFLOAT3* src, size_t srcStride,
+	size_t count, CXMMATRIX M, TransformStore store)
+{
+	TransformStream(dest, destStride, src, srcStride, count, GetTransformRows(M, false), store);
+}
+
+void MathHelper::TransformPointsSoA(float* destX, float* destY, float* destZ, const float* x, const float* y, const float* z,
+	size_t count, CXMMATRIX M, TransformStore store)
+{
+	static const TransformSoAKernel kernel = SelectTransformSoAKernel();
+	kernel(GetTransformRows(M, true), x, y, z, destX, destY, destZ, count, store);
+}
+
+void MathHelper::TransformNormalsSoA(float* destX, float* destY, float* destZ, const float* x, const float* y, const float* z,
+	size_t count, CXMMATRIX M, TransformStore store)
+{
+	static const TransformSoAKernel kernel = SelectTransformSoAKernel();
+	kernel(GetTransformRows(M, false), x, y, z, destX, destY, destZ, count, store);
+}
+
+void MathHelper::StoreTransposedMatrices(void* dest, size_t destStride, const XMFLOAT4X4* src,
+	const std::uint32_t* indices, size_t count, TransformStore store)
+{
+	std::uint8_t* out = static_cast<std::uint8_t*>(dest);
 
-		// Ignore points outside the unit sphere in order to get an even distribution
-		// over the unit sphere.  Otherwise points will clump more on the sphere near
-		// the corners of the cube.
+#if defined(_XM_SSE_INTRINSICS_)
+	const bool stream = store == TransformStore::Streaming &&
+		((reinterpret_cast<std::uintptr_t>(out) | destStride) & 15) == 0;
 
-		if( XMVector3Greater( XMVector3LengthSq(v), One) )
-			continue;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const size_t index = indices ? indices[i] : i;
+		const float* in = &src[index]._11;
+		float* slot = reinterpret_cast<float*>(out + index * destStride);
+
+		__m128 r0 = _mm_loadu_ps(in);
+		__m128 r1 = _mm_loadu_ps(in + 4);
+		__m128 r2 = _mm_loadu_ps(in + 8);
+		__m128 r3 = _mm_loadu_ps(in + 12);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
 
-		// Ignore points in the bottom hemisphere.
-		if( XMVector3Less( XMVector3Dot(n, v), Zero ) )
-			continue;
+		if (stream)
+		{
+			_mm_stream_ps(slot, r0);
+			_mm_stream_ps(slot + 4, r1);
+			_mm_stream_ps(slot + 8, r2);
+			_mm_stream_ps(slot + 12, r3);
+		}
+		else
+		{
+			_mm_storeu_ps(slot, r0);
+			_mm_storeu_ps(slot + 4, r1);
+			_mm_storeu_ps(slot + 8, r2);
+			_mm_storeu_ps(slot + 12, r3);
+		}
+	}
 
-		return XMVector3Normalize(v);
+	if (stream)
+		_mm_sfence();
+#else
+	for (size_t i = 0; i < count; ++i)
+	{
+		const size_t index = indices ? indices[i] : i;
+		XMStoreFloat4x4(reinterpret_cast<XMFLOAT4X4*>(out + index * destStride), XMMatrixTranspose(XMLoadFloat4x4(&src[index])));
 	}
+#endif
 }
\ No newline at end of file
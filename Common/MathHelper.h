@@ -10,26 +10,112 @@
 #include <DirectXMath.h>
 #include <cstdint>
 
+// Distributions of unit vectors for RandomGenerator::FillDirections and
+// MathHelper::HammersleyDirections.  The hemispheres are about a given normal.
+enum class DirectionDistribution
+{
+	Sphere,
+	Hemisphere,
+
+	// Density proportional to the cosine of the angle to the normal, for ambient
+	// occlusion and diffuse sampling.
+	CosineHemisphere
+};
+
+// How the batch transforms in MathHelper write their output.  Streaming stores bypass
+// the cache, for output that will not be read back soon such as mapped upload memory.
+enum class TransformStore
+{
+	Cached,
+	Streaming
+};
+
+// xoshiro256++ (Blackman and Vigna): a small, fast generator with a period of 2^256 - 1
+// that passes the usual statistical test suites.  Not for cryptography.
+//
+// A generator is not thread safe; give each thread or task its own, seeded explicitly
+// for repeatable results, or use MathHelper::ThreadRandom.  The Fill functions run two
+// lanes of the generator side by side with SSE2, the second lane 2^128 draws ahead of the
+// first, and give the same numbers whether or not SSE2 is available.
+class RandomGenerator
+{
+public:
+	explicit RandomGenerator(std::uint64_t seed = 0);
+
+	// Restarts the generator at the stream of seed, expanded to the full state with SplitMix64.
+	void Seed(std::uint64_t seed);
+
+	// Advances the generator by 2^192 draws.  Jumping copies of one generator 0, 1, 2...
+	// times gives streams for threads or tasks that will never overlap.
+	void LongJump();
+
+	std::uint64_t NextU64();
+	std::uint32_t NextU32() { return (std::uint32_t)(NextU64() >> 32); }
+
+	// Returns a float in [0, 1) with 24 random bits.
+	float NextFloat() { return (float)(NextU64() >> 40) * (1.0f / 16777216.0f); }
+
+	// Returns a float in [a, b).
+	float NextFloat(float a, float b) { return a + NextFloat() * (b - a); }
+
+	// Returns an int in [a, b], without modulo bias (Lemire's multiply and reject).
+	int NextInt(int a, int b);
+
+	// Fills dest with count floats in [a, b), four per step.
+	void FillFloats(float* dest, size_t count, float a = 0.0f, float b = 1.0f);
+
+	// Fills dest with count vectors whose components lie between those of a and b.
+	void FillVectors(DirectX::XMFLOAT3* dest, size_t count, DirectX::FXMVECTOR a, DirectX::FXMVECTOR b);
+	void FillVectors(DirectX::XMFLOAT4* dest, size_t count, DirectX::FXMVECTOR a, DirectX::FXMVECTOR b);
+
+	// Fills dest with count random unit vectors drawn directly from the distribution, with
+	// no rejected candidates, about the unit normal n (ignored for the sphere).
+	void FillDirections(DirectX::XMFLOAT3* dest, size_t count, DirectionDistribution distribution,
+		DirectX::FXMVECTOR n);
+
+private:
+	std::uint64_t NextLane(int lane);
+	void JumpLane(int lane, const std::uint64_t (&polynomial)[4]);
+
+	// Calls store(i, v) for blockCount blocks of four floats in [0, 1), two from each lane.
+	template<typename Store>
+	void GenerateBlocks(size_t blockCount, const Store& store);
+
+	// m_state[k][lane], so the two lanes of each state word can be loaded as one vector.
+	// NextU64 and the other single draws only use lane 0.
+	alignas(16) std::uint64_t m_state[4][2];
+};
+
 class MathHelper
 {
 public:
 	// Returns random float in [0, 1).
 	static float RandF()
 	{
-		return (float)(rand()) / (float)RAND_MAX;
+		return ThreadRandom().NextFloat();
 	}
 
 	// Returns random float in [a, b).
 	static float RandF(float a, float b)
 	{
-		return a + RandF()*(b-a);
+		return ThreadRandom().NextFloat(a, b);
 	}
 
+	// Returns random int in [a, b].
 	static int Rand(int a, int b)
 	{
-		return a + rand() % ((b - a) + 1);
+		return ThreadRandom().NextInt(a, b);
 	}
 
+	// The generator behind RandF and Rand.  Every thread has its own, so they never
+	// contend; hot loops should keep the reference or use its Fill functions.  On its
+	// first draw after a seed, a thread takes the next of the seed's streams, each one
+	// long jump past the last, so single threaded code replays exactly after SeedRandom.
+	static RandomGenerator& ThreadRandom();
+
+	// Reseeds the generators of all threads, which pick the new seed up at their next draw.
+	static void SeedRandom(std::uint64_t seed);
+
 	template<typename T>
 	static T Min(const T& a, const T& b)
 	{
@@ -68,16 +154,31 @@ public:
 
 	static DirectX::XMMATRIX InverseTranspose(DirectX::CXMMATRIX M)
 	{
-		// Inverse-transpose is just applied to normals.  So zero out
-		// translation row so that it doesn't get into our inverse-transpose
-		// calculation--we don't want the inverse-transpose of the translation.
-		DirectX::XMMATRIX A = M;
-		A.r[3] = DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-
-		DirectX::XMVECTOR det = DirectX::XMMatrixDeterminant(A);
-		return DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(&det, A));
+		// Inverse-transpose is just applied to normals, so only the upper 3x3 of M
+		// matters and the translation must not get into the result.
+		return InverseTransposeAffine(M);
 	}
 
+	// Closed form inverses for the matrices a frame is made of.  They are much cheaper than
+	// XMMatrixInverse and agree with it to within float rounding.  Each assumes the form it
+	// is named after and gives garbage for anything else.
+
+	// Inverse of a rotation followed by a translation, such as a view matrix: the
+	// transposed rotation and the translation undone along it.
+	static DirectX::XMMATRIX InverseRigid(DirectX::CXMMATRIX M);
+
+	// Inverse of any 3x3 transform (rotation, scale, shear) followed by a translation,
+	// from the cofactors of the 3x3.
+	static DirectX::XMMATRIX InverseAffine(DirectX::CXMMATRIX M);
+
+	// Inverse transpose of the upper 3x3 of an affine matrix, with no translation, for
+	// transforming normals.  The cofactors of the 3x3 divided by its determinant.
+	static DirectX::XMMATRIX InverseTransposeAffine(DirectX::CXMMATRIX M);
+
+	// Inverse of a perspective projection from any of the XMMatrixPerspective functions,
+	// left or right handed and centred or off centre.
+	static DirectX::XMMATRIX InversePerspective(DirectX::CXMMATRIX P);
+
 	static DirectX::XMFLOAT4X4 Identity4x4()
 	{
 		static DirectX::XMFLOAT4X4 I(
@@ -89,9 +190,51 @@ public:
 		return I;
 	}
 
+	// Transforms count points by the affine matrix M, as XMVector3TransformCoord does but
+	// without the divide by w.  The strides are the byte distances between consecutive
+	// points, so positions can be read from and written into interleaved vertices, and
+	// dest may be src.  Packed arrays (both strides sizeof(XMFLOAT3)) run four points at
+	// a time with SSE, and only they use streaming stores.
+	static void TransformPoints(DirectX::XMFLOAT3* dest, size_t destStride, const DirectX::XMFLOAT3* src, size_t srcStride,
+		size_t count, DirectX::CXMMATRIX M, TransformStore store = TransformStore::Cached);
+
+	// Transforms count normals by M as XMVector3TransformNormal does, ignoring its
+	// translation.  Pass the inverse transpose for matrices that scale unevenly; the
+	// results are not renormalized.
+	static void TransformNormals(DirectX::XMFLOAT3* dest, size_t destStride, const DirectX::XMFLOAT3* src, size_t srcStride,
+		size_t count, DirectX::CXMMATRIX M, TransformStore store = TransformStore::Cached);
+
+	// The same transforms over structure-of-arrays streams, with x, y and z in separate
+	// arrays.  These run 16, 8 or 4 wide with AVX-512, AVX2 and FMA, or SSE, whichever the
+	// CPU supports, chosen on first use.  Streaming stores are used when the three outputs
+	// share the same alignment; otherwise streaming is skipped and the same SIMD loop
+	// writes them with ordinary stores.
+	static void TransformPointsSoA(float* destX, float* destY, float* destZ, const float* x, const float* y, const float* z,
+		size_t count, DirectX::CXMMATRIX M, TransformStore store = TransformStore::Cached);
+	static void TransformNormalsSoA(float* destX, float* destY, float* destZ, const float* x, const float* y, const float* z,
+		size_t count, DirectX::CXMMATRIX M, TransformStore store = TransformStore::Cached);
+
+	// Writes the transpose of src[i] to dest + i * destStride for each of the count
+	// indices, or for 0 to count - 1 if indices is null.  This is the per-object constant
+	// buffer update: each matrix is loaded, transposed in registers and stored straight
+	// into its mapped slot.  Pass TransformStore::Streaming for write-combined memory such
+	// as a mapped upload heap; it is used when dest and destStride are multiples of 16
+	// bytes, as constant buffer slots always are.  Into ordinary memory, streaming stores
+	// would push out the slots that are about to be read, so they are not the default.
+	static void StoreTransposedMatrices(void* dest, size_t destStride, const DirectX::XMFLOAT4X4* src,
+		const std::uint32_t* indices, size_t count, TransformStore store = TransformStore::Cached);
+
 	static DirectX::XMVECTOR RandUnitVec3();
 	static DirectX::XMVECTOR RandHemisphereUnitVec3(DirectX::XMVECTOR n);
 
+	// Fills dest with the count directions of a Hammersley point set mapped onto the
+	// distribution about the unit normal n.  The points are evenly spread rather than
+	// random, so a small ambient occlusion kernel covers the hemisphere without clumps.
+	// A nonzero scramble gives a different set with the same spread, for example one
+	// per frame or per pixel tile.
+	static void HammersleyDirections(DirectX::XMFLOAT3* dest, std::uint32_t count, DirectionDistribution distribution,
+		DirectX::FXMVECTOR n, std::uint32_t scramble = 0);
+
 	static const float Infinity;
 	static const float Pi;
 
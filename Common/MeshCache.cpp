@@ -0,0 +1,349 @@
+#include "MeshCache.h"
+
+#include <cstring>
+
+namespace
+{
+	const std::uint32_t s_meshCacheMagic = 0x4843534d; // "MSCH"
+	const std::uint32_t s_meshCacheVersion = 1;
+	const std::uint64_t s_sectionAlignment = 16;
+
+	struct MeshCacheStream
+	{
+		std::uint64_t m_offset;
+		std::uint32_t m_byteSize;
+		std::uint32_t m_byteStride;
+	};
+
+	struct MeshCacheHeader
+	{
+		std::uint32_t m_magic;
+		std::uint32_t m_version;
+		std::uint64_t m_key;
+		std::uint64_t m_fileSize;
+
+		MeshCacheStream m_vertices;
+		MeshCacheStream m_colors;
+
+		std::uint64_t m_indexOffset;
+		std::uint32_t m_indexByteSize;
+		std::uint32_t m_indexFormat;
+
+		std::uint64_t m_submeshOffset;
+		std::uint32_t m_submeshCount;
+		std::uint32_t m_reserved;
+	};
+
+	struct MeshCacheSubmesh
+	{
+		char m_name[48];
+
+		std::uint32_t m_indexCount;
+		std::uint32_t m_startIndexLocation;
+		std::int32_t m_baseVertexLocation;
+		std::uint32_t m_reserved;
+
+		DirectX::XMFLOAT3 m_boxCenter;
+		DirectX::XMFLOAT3 m_boxExtents;
+		DirectX::XMFLOAT3 m_sphereCenter;
+		float m_sphereRadius;
+	};
+
+	std::uint64_t AlignSection(std::uint64_t offset)
+	{
+		return (offset + s_sectionAlignment - 1) & ~(s_sectionAlignment - 1);
+	}
+
+	bool SectionFits(std::uint64_t offset, std::uint64_t byteSize, std::uint64_t fileSize)
+	{
+		return offset % s_sectionAlignment == 0 && offset <= fileSize && byteSize <= fileSize - offset;
+	}
+
+	bool StreamFits(const MeshCacheStream& stream, std::uint64_t fileSize)
+	{
+		if (stream.m_byteSize == 0)
+			return true;
+
+		return stream.m_byteStride != 0 &&
+			stream.m_byteSize % stream.m_byteStride == 0 &&
+			SectionFits(stream.m_offset, stream.m_byteSize, fileSize);
+	}
+
+	UINT IndexByteSize(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R16_UINT:
+			return sizeof(std::uint16_t);
+		case DXGI_FORMAT_R32_UINT:
+			return sizeof(std::uint32_t);
+		default:
+			return 0;
+		}
+	}
+
+	UINT BlobSize(const Microsoft::WRL::ComPtr<ID3DBlob>& blob)
+	{
+		return blob ? (UINT)blob->GetBufferSize() : 0;
+	}
+}
+
+MeshCacheKey& MeshCacheKey::Add(const void* data, size_t size)
+{
+	const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i)
+	{
+		m_hash ^= bytes[i];
+		m_hash *= 1099511628211ull;
+	}
+
+	return *this;
+}
+
+MeshCacheKey& MeshCacheKey::Add(const std::string& text)
+{
+	// Include the length so that consecutive strings cannot run into each other.
+	std::uint64_t length = text.size();
+	Add(&length, sizeof(length));
+
+	return Add(text.data(), text.size());
+}
+
+MeshCacheFile::~MeshCacheFile()
+{
+	Close();
+}
+
+bool MeshCacheFile::Open(const std::wstring& filename, std::uint64_t key)
+{
+	Close();
+
+	m_file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_file, &fileSize) || (std::uint64_t)fileSize.QuadPart < sizeof(MeshCacheHeader))
+	{
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping != nullptr)
+		m_data = static_cast<const std::uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (m_data == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	m_size = (std::uint64_t)fileSize.QuadPart;
+
+	//
+	// Validate everything the accessors rely on, so a stale or damaged file is a miss
+	// rather than a crash.
+	//
+
+	MeshCacheHeader header;
+	std::memcpy(&header, m_data, sizeof(header));
+
+	UINT indexSize = IndexByteSize((DXGI_FORMAT)header.m_indexFormat);
+	bool valid = header.m_magic == s_meshCacheMagic &&
+		header.m_version == s_meshCacheVersion &&
+		header.m_key == key &&
+		header.m_fileSize == m_size &&
+		indexSize != 0 &&
+		header.m_indexByteSize % indexSize == 0 &&
+		StreamFits(header.m_vertices, m_size) &&
+		StreamFits(header.m_colors, m_size) &&
+		SectionFits(header.m_indexOffset, header.m_indexByteSize, m_size) &&
+		SectionFits(header.m_submeshOffset, (std::uint64_t)header.m_submeshCount * sizeof(MeshCacheSubmesh), m_size);
+
+	const MeshCacheSubmesh* submeshes = reinterpret_cast<const MeshCacheSubmesh*>(m_data + header.m_submeshOffset);
+	UINT indexCount = header.m_indexByteSize / std::max(indexSize, 1u);
+
+	for (std::uint32_t i = 0; valid && i < header.m_submeshCount; ++i)
+	{
+		const MeshCacheSubmesh& submesh = submeshes[i];
+
+		valid = std::memchr(submesh.m_name, '\0', sizeof(submesh.m_name)) != nullptr &&
+			submesh.m_startIndexLocation <= indexCount &&
+			submesh.m_indexCount <= indexCount - submesh.m_startIndexLocation;
+	}
+
+	if (!valid)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MeshCacheFile::Close()
+{
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+
+	if (m_mapping != nullptr)
+		CloseHandle(m_mapping);
+
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+
+	m_data = nullptr;
+	m_size = 0;
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+}
+
+void MeshCacheFile::CreateMeshGeometry(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, MeshGeometry& geo) const
+{
+	assert(m_data != nullptr);
+
+	MeshCacheHeader header;
+	std::memcpy(&header, m_data, sizeof(header));
+
+	auto createBuffer = [&](std::uint64_t offset, UINT byteSize, Microsoft::WRL::ComPtr<ID3DBlob>& cpu,
+		Microsoft::WRL::ComPtr<ID3D12Resource>& gpu, Microsoft::WRL::ComPtr<ID3D12Resource>& uploader)
+	{
+		if (byteSize == 0)
+			return;
+
+		ThrowIfFailed(D3DCreateBlob(byteSize, &cpu));
+		CopyMemory(cpu->GetBufferPointer(), m_data + offset, byteSize);
+
+		gpu = d3dUtil::CreateDefaultBuffer(device, cmdList, m_data + offset, byteSize, uploader);
+	};
+
+	createBuffer(header.m_vertices.m_offset, header.m_vertices.m_byteSize,
+		geo.VertexBufferCPU, geo.VertexBufferGPU, geo.VertexBufferUploader);
+	createBuffer(header.m_colors.m_offset, header.m_colors.m_byteSize,
+		geo.ColorBufferCPU, geo.ColorBufferGPU, geo.ColorBufferUploader);
+	createBuffer(header.m_indexOffset, header.m_indexByteSize,
+		geo.IndexBufferCPU, geo.IndexBufferGPU, geo.IndexBufferUploader);
+
+	geo.VertexByteStride = header.m_vertices.m_byteStride;
+	geo.VertexBufferByteSize = header.m_vertices.m_byteSize;
+	geo.ColorByteStride = header.m_colors.m_byteStride;
+	geo.ColorBufferByteSize = header.m_colors.m_byteSize;
+	geo.IndexFormat = (DXGI_FORMAT)header.m_indexFormat;
+	geo.IndexBufferByteSize = header.m_indexByteSize;
+
+	const MeshCacheSubmesh* submeshes = reinterpret_cast<const MeshCacheSubmesh*>(m_data + header.m_submeshOffset);
+	for (std::uint32_t i = 0; i < header.m_submeshCount; ++i)
+	{
+		const MeshCacheSubmesh& cached = submeshes[i];
+
+		SubmeshGeometry submesh;
+		submesh.IndexCount = cached.m_indexCount;
+		submesh.StartIndexLocation = cached.m_startIndexLocation;
+		submesh.BaseVertexLocation = cached.m_baseVertexLocation;
+		submesh.Bounds = DirectX::BoundingBox(cached.m_boxCenter, cached.m_boxExtents);
+		submesh.SphereBounds = DirectX::BoundingSphere(cached.m_sphereCenter, cached.m_sphereRadius);
+
+		geo.DrawArgs[cached.m_name] = submesh;
+	}
+}
+
+bool MeshCacheFile::Write(const std::wstring& filename, std::uint64_t key, const MeshGeometry& geo)
+{
+	if (IndexByteSize(geo.IndexFormat) == 0)
+		return false;
+
+	//
+	// Lay out the sections.
+	//
+
+	MeshCacheHeader header = {};
+	header.m_magic = s_meshCacheMagic;
+	header.m_version = s_meshCacheVersion;
+	header.m_key = key;
+
+	header.m_vertices.m_offset = AlignSection(sizeof(header));
+	header.m_vertices.m_byteSize = BlobSize(geo.VertexBufferCPU);
+	header.m_vertices.m_byteStride = geo.VertexByteStride;
+
+	header.m_colors.m_offset = AlignSection(header.m_vertices.m_offset + header.m_vertices.m_byteSize);
+	header.m_colors.m_byteSize = BlobSize(geo.ColorBufferCPU);
+	header.m_colors.m_byteStride = geo.ColorByteStride;
+
+	header.m_indexOffset = AlignSection(header.m_colors.m_offset + header.m_colors.m_byteSize);
+	header.m_indexByteSize = BlobSize(geo.IndexBufferCPU);
+	header.m_indexFormat = (std::uint32_t)geo.IndexFormat;
+
+	header.m_submeshOffset = AlignSection(header.m_indexOffset + header.m_indexByteSize);
+	header.m_submeshCount = (std::uint32_t)geo.DrawArgs.size();
+
+	header.m_fileSize = header.m_submeshOffset + header.m_submeshCount * sizeof(MeshCacheSubmesh);
+
+	//
+	// Build the file image.  Submeshes are sorted by name so the same geometry always
+	// produces the same bytes.
+	//
+
+	std::vector<std::uint8_t> image((size_t)header.m_fileSize, 0);
+	std::memcpy(image.data(), &header, sizeof(header));
+
+	if (header.m_vertices.m_byteSize > 0)
+		std::memcpy(&image[header.m_vertices.m_offset], geo.VertexBufferCPU->GetBufferPointer(), header.m_vertices.m_byteSize);
+
+	if (header.m_colors.m_byteSize > 0)
+		std::memcpy(&image[header.m_colors.m_offset], geo.ColorBufferCPU->GetBufferPointer(), header.m_colors.m_byteSize);
+
+	if (header.m_indexByteSize > 0)
+		std::memcpy(&image[header.m_indexOffset], geo.IndexBufferCPU->GetBufferPointer(), header.m_indexByteSize);
+
+	std::vector<const std::pair<const std::string, SubmeshGeometry>*> drawArgs;
+	for (const auto& drawArg : geo.DrawArgs)
+		drawArgs.push_back(&drawArg);
+
+	std::sort(drawArgs.begin(), drawArgs.end(),
+		[](const auto* a, const auto* b) { return a->first < b->first; });
+
+	for (size_t i = 0; i < drawArgs.size(); ++i)
+	{
+		const std::string& name = drawArgs[i]->first;
+		const SubmeshGeometry& submesh = drawArgs[i]->second;
+
+		MeshCacheSubmesh cached = {};
+		if (name.size() >= sizeof(cached.m_name))
+			return false;
+
+		std::memcpy(cached.m_name, name.c_str(), name.size());
+		cached.m_indexCount = submesh.IndexCount;
+		cached.m_startIndexLocation = submesh.StartIndexLocation;
+		cached.m_baseVertexLocation = submesh.BaseVertexLocation;
+		cached.m_boxCenter = submesh.Bounds.Center;
+		cached.m_boxExtents = submesh.Bounds.Extents;
+		cached.m_sphereCenter = submesh.SphereBounds.Center;
+		cached.m_sphereRadius = submesh.SphereBounds.Radius;
+
+		std::memcpy(&image[header.m_submeshOffset + i * sizeof(MeshCacheSubmesh)], &cached, sizeof(cached));
+	}
+
+	//
+	// Write it under a name private to this process and move it into place.
+	//
+
+	std::wstring tempFilename = filename + L"." + std::to_wstring(GetCurrentProcessId()) + L".tmp";
+
+	HANDLE file = CreateFileW(tempFilename.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	DWORD written = 0;
+	BOOL ok = WriteFile(file, image.data(), (DWORD)image.size(), &written, nullptr) && written == image.size();
+	CloseHandle(file);
+
+	if (!ok || !MoveFileExW(tempFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileW(tempFilename.c_str());
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,62 @@
+//***************************************************************************************
+// MeshCache.h
+//
+// A binary container for the buffers of a MeshGeometry, so generated geometry can be
+// saved once and mapped straight back into the upload path on later runs.
+//
+// The file is a fixed header followed by 16 byte aligned sections: the vertex stream,
+// the optional colour stream, the index buffer (16 or 32-bit) and the submesh table.
+// The header records the key the buffers were generated from; a file whose key,
+// format version or layout does not match is treated as a miss.
+//***************************************************************************************
+#pragma once
+
+#include "d3dUtil.h"
+
+// Builds the 64-bit key identifying cached geometry from everything that went into
+// generating it (FNV-1a over the bytes added).
+class MeshCacheKey
+{
+public:
+	MeshCacheKey& Add(const void* data, size_t size);
+	MeshCacheKey& Add(const std::string& text);
+
+	std::uint64_t Get() const { return m_hash; }
+
+private:
+	std::uint64_t m_hash = 14695981039346656037ull;
+};
+
+// A read-only view of a mesh cache file mapped into memory.  Nothing is parsed or
+// copied when it is opened; the accessors point into the mapping.
+class MeshCacheFile
+{
+public:
+	MeshCacheFile() = default;
+	~MeshCacheFile();
+
+	MeshCacheFile(const MeshCacheFile& rhs) = delete;
+	MeshCacheFile& operator=(const MeshCacheFile& rhs) = delete;
+
+	// Maps the file and validates it.  Returns false if it is missing, malformed,
+	// written by another format version or generated for a different key.
+	bool Open(const std::wstring& filename, std::uint64_t key);
+	void Close();
+
+	// Fills in geo from the mapped file: the CPU copies, the default heap buffers
+	// (recorded on cmdList, uploaded directly from the mapping) and the DrawArgs.
+	// The file can be closed as soon as this returns.
+	void CreateMeshGeometry(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, MeshGeometry& geo) const;
+
+	// Writes the CPU copies and DrawArgs of geo.  The file is written under a temporary
+	// name and then moved into place, so a reader never maps a partly written file.
+	// Submesh names must be shorter than 48 characters.
+	static bool Write(const std::wstring& filename, std::uint64_t key, const MeshGeometry& geo);
+
+private:
+	const std::uint8_t* m_data = nullptr;
+	std::uint64_t m_size = 0;
+
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+};
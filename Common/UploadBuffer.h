@@ -55,6 +55,18 @@ public:
 		memcpy(&m_mappedData[elementIndex*m_elementByteSize], &data, sizeof(T));
 	}
 
+	// Writes the transposes of matrices[indices[i]] into elements indices[i], for a T
+	// that starts with a matrix such as ObjectConstants::World.  The rest of each element
+	// is left alone.  Constant buffer elements get streaming stores, which suit the
+	// write-combined upload heap.
+	void CopyTransposedMatrices(const DirectX::XMFLOAT4X4* matrices, const std::uint32_t* indices, size_t count)
+	{
+		static_assert(sizeof(T) >= sizeof(DirectX::XMFLOAT4X4), "T must start with a 4x4 matrix");
+
+		MathHelper::StoreTransposedMatrices(m_mappedData, m_elementByteSize, matrices, indices, count,
+			m_isConstantBuffer ? TransformStore::Streaming : TransformStore::Cached);
+	}
+
 private:
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_uploadBuffer;
@@ -127,6 +127,9 @@ struct SubmeshGeometry
     // Bounding box of the geometry defined by this submesh.
     // This is used in later chapters of the book.
     DirectX::BoundingBox Bounds;
+
+    // Bounding sphere of the same geometry, for a cheaper first culling test.
+    DirectX::BoundingSphere SphereBounds;
 };
 
 struct MeshGeometry
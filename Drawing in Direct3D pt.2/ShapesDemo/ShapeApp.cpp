@@ -2,6 +2,8 @@
 
 const int gNumFrameResources = 3;
 
+static const wchar_t* const s_shapeCacheFilename = L"ShapesMeshCache.bin";
+
 ShapesApp::ShapesApp()
 	: D3DApp()
 {
@@ -230,23 +232,23 @@ void ShapesApp::UpdateObjectCBs(const Timer& gt)
 {
 	auto currObjectCB = m_currFrameResource->m_objCB.get();
 
+	m_dirtyObjects.clear();
 	for (auto& RItem : m_allRItems)
 	{
 		// Only update the cbuffer data if the constants
 		// have changed.
 		if (RItem->m_numFramesDirty > 0)
 		{
-			DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&RItem->m_world);
-
-			ObjectConstants objconstants;
-			DirectX::XMStoreFloat4x4(&objconstants.World, DirectX::XMMatrixTranspose(world));
-
-			currObjectCB->CopyData(RItem->m_objCBIndex, objconstants);
+			m_dirtyObjects.push_back(RItem->m_objCBIndex);
 
 			// Next FrameResource needs to be updated too
 			RItem->m_numFramesDirty--;
 		}
 	}
+
+	// ObjectConstants is just the transposed world matrix, so the dirty
+	// ones are written straight into the mapped cbuffer.
+	currObjectCB->CopyTransposedMatrices(m_objectWorlds.data(), m_dirtyObjects.data(), m_dirtyObjects.size());
 }
 
 void ShapesApp::UpdateMainPassCB(const Timer& gt)
@@ -254,13 +256,13 @@ void ShapesApp::UpdateMainPassCB(const Timer& gt)
 	DirectX::XMMATRIX view = DirectX::XMLoadFloat4x4(&m_view);
 	DirectX::XMMATRIX proj = DirectX::XMLoadFloat4x4(&m_proj);
 	DirectX::XMMATRIX viewProj = DirectX::XMMatrixMultiply(view, proj);
-	DirectX::XMMATRIX invView =
-		DirectX::XMMatrixInverse(&DirectX::XMMatrixDeterminant(view), view);
-	DirectX::XMMATRIX invProj =
-		DirectX::XMMatrixInverse(&DirectX::XMMatrixDeterminant(proj), proj);
-	DirectX::XMMATRIX invViewProj =
-		DirectX::XMMatrixInverse(&DirectX::XMMatrixDeterminant(viewProj),
-			viewProj);
+
+	// The view is rigid and the projection a perspective, so both have closed form
+	// inverses, and the inverse of their product is the product of the inverses.
+	DirectX::XMMATRIX invView = MathHelper::InverseRigid(view);
+	DirectX::XMMATRIX invProj = MathHelper::InversePerspective(proj);
+	DirectX::XMMATRIX invViewProj = DirectX::XMMatrixMultiply(invProj, invView);
+
 	DirectX::XMStoreFloat4x4(&m_mainPassCB.View,
 		DirectX::XMMatrixTranspose(view));
 	DirectX::XMStoreFloat4x4(&m_mainPassCB.InvView,
@@ -413,143 +415,120 @@ void ShapesApp::BuildShadersAndInputLayout()
 
 void ShapesApp::BuildShapeGeometry()
 {
-	GeometryGenerator geoGen;
-
-	GeometryGenerator::MeshData box =
-		geoGen.CreateBox(1.5f, 0.5f, 1.5f, 3);
-	GeometryGenerator::MeshData grid =
-		geoGen.CreateGrid(20.0f, 30.0f, 60, 40);
-	GeometryGenerator::MeshData sphere =
-		geoGen.CreateSphere(0.5f, 20, 20);
-	GeometryGenerator::MeshData cylinder =
-		geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20);
-
-	/*
-	We are concatenating all the geometry into one
-	big vertex / index
-	buffer. So define the regions in the buffer each
-	submesh covers.
-	*/
-
-	// Cache the vertex offsets to each object in the
-	// concatenated vertex buffer.
-	UINT boxVtxOffset = 0;
-	UINT gridVtxOffset = (UINT)box.m_vertices.size();
-	UINT sphereVtxOffset = gridVtxOffset +
-		(UINT)grid.m_vertices.size();
-	UINT cylinderVtxOffset = sphereVtxOffset +
-		(UINT)sphere.m_vertices.size();
-
-	// Cache the starting index for each object in the
-	// concatenated index buffer.
-	UINT boxIdxOffset = 0;
-	UINT gridIdxOffset = (UINT)box.m_indices32.size();
-	UINT sphereIdxOffset = gridIdxOffset +
-		(UINT)grid.m_indices32.size();
-	UINT cylinderIdxOffset = sphereIdxOffset +
-		(UINT)sphere.m_indices32.size();
-
-	// Define the SubmeshGeometry that cover different
-	// regions of the vertex/index buffers.
-	SubmeshGeometry boxSubmesh;
-	boxSubmesh.IndexCount = (UINT)box.m_indices32.size();
-	boxSubmesh.StartIndexLocation = boxIdxOffset;
-	boxSubmesh.BaseVertexLocation = boxVtxOffset;
-
-	SubmeshGeometry gridSubmesh;
-	gridSubmesh.IndexCount = (UINT)grid.m_indices32.size();
-	gridSubmesh.StartIndexLocation = gridIdxOffset;
-	gridSubmesh.BaseVertexLocation = gridVtxOffset;
-
-	SubmeshGeometry sphereSubmesh;
-	sphereSubmesh.IndexCount = (UINT)sphere.m_indices32.size();
-	sphereSubmesh.StartIndexLocation = sphereIdxOffset;
-	sphereSubmesh.BaseVertexLocation = sphereVtxOffset;
-
-	SubmeshGeometry cylinderSubmesh;
-	cylinderSubmesh.IndexCount = (UINT)cylinder.m_indices32.size();
-	cylinderSubmesh.StartIndexLocation = cylinderIdxOffset;
-	cylinderSubmesh.BaseVertexLocation = cylinderVtxOffset;
-
-	// Extract the vertex elements we are interested in and pack the
-	// vertices of all the meshes into one vertex buffer.
-
-	auto totalVertexCount =
-		box.m_vertices.size() +
-		grid.m_vertices.size() +
-		sphere.m_vertices.size() +
-		cylinder.m_vertices.size();
-
-	std::vector<Vertex> vertices(totalVertexCount);
-
-	UINT k = 0;
-	for (size_t i = 0; i < box.m_vertices.size(); ++i, ++k)
+	// Everything the shape buffers are generated from.  It is hashed into the mesh
+	// cache key with the output versions of the generator and the batcher, so changing
+	// any value here, or the code that turns it into buffers, regenerates the cache.
+	struct ShapeParameters
 	{
-		vertices[k].Pos = box.m_vertices[i].m_position;
-		vertices[k].Color = DirectX::XMFLOAT4(DirectX::Colors::DarkGreen);
-	}
+		std::uint32_t m_vertexByteStride = sizeof(Vertex);
+
+		float m_boxWidth = 1.5f, m_boxHeight = 0.5f, m_boxDepth = 1.5f;
+		std::uint32_t m_boxSubdivisions = 3;
+		float m_gridWidth = 20.0f, m_gridDepth = 30.0f;
+		std::uint32_t m_gridRows = 60, m_gridColumns = 40;
+		float m_sphereRadius = 0.5f;
+		float m_cylinderBottomRadius = 0.5f, m_cylinderTopRadius = 0.3f, m_cylinderHeight = 3.0f;
+
+		// The curved shapes are tessellated to stay within 7.5mm of the true surface, about
+		// what 20 slices and stacks gave the sphere, rather than to fixed slice counts.
+		GeometryGenerator::TessellationTarget m_curvedTarget = { 0.0075f, 0.0f, 1000 };
+		float m_lodTargets[2] = { 0.5f, 0.25f };
+
+		// The seam columns come from sin/cos of 2pi rather than copies of the first
+		// column, so they are a few ulps away from the vertices they should merge with.
+		float m_weldTolerance = 1e-5f;
+
+		DirectX::XMFLOAT4 m_boxColor = DirectX::XMFLOAT4(DirectX::Colors::DarkGreen);
+		DirectX::XMFLOAT4 m_gridColor = DirectX::XMFLOAT4(DirectX::Colors::ForestGreen);
+		DirectX::XMFLOAT4 m_sphereColor = DirectX::XMFLOAT4(DirectX::Colors::Crimson);
+		DirectX::XMFLOAT4 m_cylinderColor = DirectX::XMFLOAT4(DirectX::Colors::SteelBlue);
+	};
 
-	for (size_t i = 0; i < grid.m_vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = grid.m_vertices[i].m_position;
-		vertices[k].Color = DirectX::XMFLOAT4(DirectX::Colors::ForestGreen);
-	}
+	const ShapeParameters params;
+	const std::uint64_t cacheKey = MeshCacheKey()
+		.Add(&GeometryGenerator::s_outputVersion, sizeof(GeometryGenerator::s_outputVersion))
+		.Add(&GeometryBatcher::s_outputVersion, sizeof(GeometryBatcher::s_outputVersion))
+		.Add(&params, sizeof(params))
+		.Get();
 
-	for (size_t i = 0; i < sphere.m_vertices.size(); ++i, ++k)
+	// A cache hit maps the buffers and uploads them as they are, skipping generation.
+	MeshCacheFile cache;
+	if (cache.Open(s_shapeCacheFilename, cacheKey))
 	{
-		vertices[k].Pos = sphere.m_vertices[i].m_position;
-		vertices[k].Color = DirectX::XMFLOAT4(DirectX::Colors::Crimson);
-	}
+		auto geo = std::make_unique<MeshGeometry>();
+		geo->Name = "shapeGeo";
+		cache.CreateMeshGeometry(m_device.Get(), m_commandList.Get(), *geo);
 
-	for (size_t i = 0; i < cylinder.m_vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = cylinder.m_vertices[i].m_position;
-		vertices[k].Color = DirectX::XMFLOAT4(DirectX::Colors::SteelBlue);
+		m_geometries[geo->Name] = std::move(geo);
+		return;
 	}
 
-	std::vector<std::uint16_t> indices;
-	indices.insert(indices.end(),
-		std::begin(box.GetIndices16()),
-		std::end(box.GetIndices16()));
-
-	indices.insert(indices.end(),
-		std::begin(grid.GetIndices16()),
-		std::end(grid.GetIndices16()));
-
-	indices.insert(indices.end(),
-		std::begin(sphere.GetIndices16()),
-		std::end(sphere.GetIndices16()));
-
-	indices.insert(indices.end(),
-		std::begin(cylinder.GetIndices16()),
-		std::end(cylinder.GetIndices16()));
+	// The generated meshes only live until they are copied into the buffers below,
+	// so build them all in one arena and release it in one go.
+	std::pmr::monotonic_buffer_resource arena(1 << 20);
+	GeometryGenerator geoGen(&arena);
 
-	const UINT vbByteSize = (UINT)vertices.size() *
-		sizeof(Vertex);
-	const UINT ibByteSize = (UINT)indices.size() *
-		sizeof(std::uint16_t);
+	GeometryGenerator::MeshData box =
+		geoGen.CreateBox(params.m_boxWidth, params.m_boxHeight, params.m_boxDepth, params.m_boxSubdivisions);
+	GeometryGenerator::MeshData grid =
+		geoGen.CreateGrid(params.m_gridWidth, params.m_gridDepth, params.m_gridRows, params.m_gridColumns);
+	GeometryGenerator::MeshData sphere =
+		geoGen.CreateSphere(params.m_sphereRadius, params.m_curvedTarget).m_meshData;
+	GeometryGenerator::MeshData cylinder =
+		geoGen.CreateCylinder(params.m_cylinderBottomRadius, params.m_cylinderTopRadius, params.m_cylinderHeight,
+			params.m_curvedTarget).m_meshData;
+
+	// The shapes are drawn with position and colour only, so the vertices the generators
+	// split along face edges and texture seams can be shared.  This also closes the seams
+	// for the simplifier, which would otherwise lock them as open boundaries.
+	geoGen.Weld(box, params.m_weldTolerance, GeometryGenerator::WeldPosition);
+	geoGen.Weld(grid, params.m_weldTolerance, GeometryGenerator::WeldPosition);
+	geoGen.Weld(sphere, params.m_weldTolerance, GeometryGenerator::WeldPosition);
+	geoGen.Weld(cylinder, params.m_weldTolerance, GeometryGenerator::WeldPosition);
+
+	// The generators emit their triangles ring by ring, so reorder them for the
+	// post-transform vertex cache before they are packed together.
+	geoGen.OptimizeVertexCache(box);
+	geoGen.OptimizeVertexCache(grid);
+	geoGen.OptimizeVertexCache(sphere);
+	geoGen.OptimizeVertexCache(cylinder);
+
+	// Simplified levels for distant spheres and cylinders.  Each level uses a
+	// prefix of the full-detail vertices, so only its indices are appended.
+	std::vector<float> lodTargets(std::begin(params.m_lodTargets), std::end(params.m_lodTargets));
+	std::pmr::vector<GeometryGenerator::MeshData> sphereLods = geoGen.BuildLodChain(sphere, lodTargets);
+	std::pmr::vector<GeometryGenerator::MeshData> cylinderLods = geoGen.BuildLodChain(cylinder, lodTargets);
+	sphere = std::move(sphereLods[0]);
+	cylinder = std::move(cylinderLods[0]);
+
+	// Concatenate all the geometry into one big vertex and index buffer, with a
+	// submesh per shape and per level of detail.  Each level only appends indices
+	// to the buffer, drawn from the vertices of its full-detail shape.
+	GeometryBatcher batcher;
+	batcher.Add("box", box, params.m_boxColor);
+	batcher.Add("grid", grid, params.m_gridColor);
+	uint32 sphereVertices = batcher.Add("sphere", sphere, params.m_sphereColor);
+	uint32 cylinderVertices = batcher.Add("cylinder", cylinder, params.m_cylinderColor);
+
+	for (size_t i = 1; i < sphereLods.size(); ++i)
+		batcher.AddIndices("sphere_lod" + std::to_string(i), sphereVertices, sphereLods[i]);
+
+	for (size_t i = 1; i < cylinderLods.size(); ++i)
+		batcher.AddIndices("cylinder_lod" + std::to_string(i), cylinderVertices, cylinderLods[i]);
+
+	// Extract the vertex elements we are interested in.
+	GeometryGenerator::VertexLayout layout;
+	layout.m_stride = sizeof(Vertex);
+	layout.m_positionOffset = offsetof(Vertex, Pos);
+	layout.m_colorOffset = offsetof(Vertex, Color);
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->Name = "shapeGeo";
 
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+	batcher.Build(m_device.Get(), m_commandList.Get(), layout, *geo);
 
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(m_device.Get(), m_commandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(m_device.Get(), m_commandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
-
-	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-	geo->IndexBufferByteSize = ibByteSize;
-
-	geo->DrawArgs["box"] = boxSubmesh;
-	geo->DrawArgs["grid"] = gridSubmesh;
-	geo->DrawArgs["sphere"] = sphereSubmesh;
-	geo->DrawArgs["cylinder"] = cylinderSubmesh;
+	// Failing to write the cache only costs the next run a regeneration.
+	MeshCacheFile::Write(s_shapeCacheFilename, cacheKey, *geo);
 
 	m_geometries[geo->Name] = std::move(geo);
 }
@@ -613,10 +592,8 @@ void ShapesApp::BuildRenderItems()
 {
 	auto boxRItem = std::make_unique<RenderItem>();
 
-	DirectX::XMStoreFloat4x4(&boxRItem->m_world, DirectX::XMMatrixScaling(2.0f, 2.0f, 2.0f) *
+	boxRItem->m_objCBIndex = AddObjectWorld(DirectX::XMMatrixScaling(2.0f, 2.0f, 2.0f) *
 		DirectX::XMMatrixTranslation(0.0f, 0.5f, 0.0f));
-
-	boxRItem->m_objCBIndex = 0;
 	boxRItem->m_geo = m_geometries["shapeGeo"].get();
 	boxRItem->m_primitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 	boxRItem->m_indexCount = boxRItem->m_geo->DrawArgs["box"].IndexCount;
@@ -627,8 +604,7 @@ void ShapesApp::BuildRenderItems()
 	m_allRItems.push_back(std::move(boxRItem));
 
 	auto gridRItem = std::make_unique<RenderItem>();
-	gridRItem->m_world = MathHelper::Identity4x4();
-	gridRItem->m_objCBIndex = 1;
+	gridRItem->m_objCBIndex = AddObjectWorld(DirectX::XMMatrixIdentity());
 	gridRItem->m_geo = m_geometries["shapeGeo"].get();
 	gridRItem->m_primitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 	gridRItem->m_indexCount = gridRItem->m_geo->DrawArgs["grid"].IndexCount;
@@ -638,13 +614,11 @@ void ShapesApp::BuildRenderItems()
 		BaseVertexLocation;
 	m_allRItems.push_back(std::move(gridRItem));
 
-	UINT objCBIndex = 2;
 	for (int i = 0; i < 5; ++i)
 	{
 		auto leftCylRitem = std::make_unique<RenderItem>();
 		DirectX::XMMATRIX leftCylWorld = DirectX::XMMatrixTranslation(-5.0f, 1.5f, -10.0f + i * 5.0f);
-		XMStoreFloat4x4(&leftCylRitem->m_world, leftCylWorld);
-		leftCylRitem->m_objCBIndex = objCBIndex++;
+		leftCylRitem->m_objCBIndex = AddObjectWorld(leftCylWorld);
 		leftCylRitem->m_geo = m_geometries["shapeGeo"].get();
 		leftCylRitem->m_primitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		leftCylRitem->m_indexCount = leftCylRitem->m_geo->DrawArgs["cylinder"].IndexCount;
@@ -654,8 +628,7 @@ void ShapesApp::BuildRenderItems()
 
 		auto rightCylRitem = std::make_unique<RenderItem>();
 		DirectX::XMMATRIX rightCylWorld = DirectX::XMMatrixTranslation(+5.0f, 1.5f, -10.0f + i * 5.0f);
-		XMStoreFloat4x4(&rightCylRitem->m_world, rightCylWorld);
-		rightCylRitem->m_objCBIndex = objCBIndex++;
+		rightCylRitem->m_objCBIndex = AddObjectWorld(rightCylWorld);
 		rightCylRitem->m_geo = m_geometries["shapeGeo"].get();
 		rightCylRitem->m_primitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		rightCylRitem->m_indexCount = rightCylRitem->m_geo->DrawArgs["cylinder"].IndexCount;
@@ -665,8 +638,7 @@ void ShapesApp::BuildRenderItems()
 
 		auto leftSphereRitem = std::make_unique<RenderItem>();
 		DirectX::XMMATRIX leftSphereWorld = DirectX::XMMatrixTranslation(-5.0f, 3.5f, -10.0f + i * 5.0f);
-		XMStoreFloat4x4(&leftSphereRitem->m_world, leftSphereWorld);
-		leftSphereRitem->m_objCBIndex = objCBIndex++;
+		leftSphereRitem->m_objCBIndex = AddObjectWorld(leftSphereWorld);
 		leftSphereRitem->m_geo = m_geometries["shapeGeo"].get();
 		leftSphereRitem->m_primitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		leftSphereRitem->m_indexCount = leftSphereRitem->m_geo->DrawArgs["sphere"].IndexCount;
@@ -676,8 +648,7 @@ void ShapesApp::BuildRenderItems()
 
 		auto rightSphereRitem = std::make_unique<RenderItem>();
 		DirectX::XMMATRIX rightSphereWorld = DirectX::XMMatrixTranslation(+5.0f, 3.5f, -10.0f + i * 5.0f);
-		XMStoreFloat4x4(&rightSphereRitem->m_world, rightSphereWorld);
-		rightSphereRitem->m_objCBIndex = objCBIndex++;
+		rightSphereRitem->m_objCBIndex = AddObjectWorld(rightSphereWorld);
 		rightSphereRitem->m_geo = m_geometries["shapeGeo"].get();
 		rightSphereRitem->m_primitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		rightSphereRitem->m_indexCount = rightSphereRitem->m_geo->DrawArgs["sphere"].IndexCount;
@@ -691,6 +662,15 @@ void ShapesApp::BuildRenderItems()
 		m_opaqueRItems.push_back(e.get());
 }
 
+UINT ShapesApp::AddObjectWorld(DirectX::FXMMATRIX world)
+{
+	DirectX::XMFLOAT4X4 stored;
+	DirectX::XMStoreFloat4x4(&stored, world);
+	m_objectWorlds.push_back(stored);
+
+	return (UINT)m_objectWorlds.size() - 1;
+}
+
 void ShapesApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
 {
 	UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
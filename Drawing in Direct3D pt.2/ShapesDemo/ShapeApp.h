@@ -3,18 +3,15 @@
 #include "../../Common/d3dApp.h"
 #include "../../Common/MathHelper.h"
 #include "../../Common/UploadBuffer.h"
+#include "../../Common/GeometryBatcher.h"
 #include "../../Common/GeometryGenerator.h"
+#include "../../Common/MeshCache.h"
 #include "FrameResource.h"
 
 struct RenderItem
 {
     RenderItem() = default;
 
-    // world matrix of the shape that describes the object's local space
-    // relative to the world space, which define the position,
-    // orientation, and scale of the object in the world.
-    DirectX::XMFLOAT4X4 m_world;
-
     // Dirty flag indicating the object data has changed and we need to
     // update the constant buffer. Because we have an object cBuffer for
     // each FrameResouce, we have to apply the update to each
@@ -24,7 +21,8 @@ struct RenderItem
     int m_numFramesDirty = gNumFrameResources;
 
     // Index into GPU constant buffer corresponding to the ObjectCB
-    // for this RenderItem
+    // for this RenderItem, and into ShapesApp::m_objectWorlds for its
+    // world matrix
     UINT m_objCBIndex = -1;
 
     // Geometry associated with this RenderItem. Note that multiple
@@ -73,6 +71,7 @@ private:
     void BuildPSOs();
     void BuildFrameResources();
     void BuildRenderItems();
+    UINT AddObjectWorld(DirectX::FXMMATRIX world);
     void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
 
     std::vector <std::unique_ptr<FrameResource>> m_frameResources;
@@ -92,6 +91,13 @@ private:
 
     std::vector<std::unique_ptr<RenderItem>> m_allRItems;
 
+    // World matrices of the render items, indexed by m_objCBIndex.  They
+    // describe each object's local space relative to the world space: its
+    // position, orientation, and scale.  Kept in one array so the dirty ones
+    // can be transposed into the object cbuffer in a single pass.
+    std::vector<DirectX::XMFLOAT4X4> m_objectWorlds;
+    std::vector<std::uint32_t> m_dirtyObjects;
+
     // Render items divided by PSO
     std::vector<RenderItem*> m_opaqueRItems;
     std::vector<RenderItem*> m_transparentRItems;
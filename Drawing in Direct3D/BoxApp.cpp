@@ -6,6 +6,112 @@
 //*********************************************************************
 #include "BoxApp.h"
 
+// The fixed meshes are compile-time tables so building them needs no construction
+// at run time and they can be copied straight into the upload buffers.  The colours
+// repeat the values of DirectX::Colors, which are not constexpr.
+static constexpr DirectX::XMFLOAT4 s_white(1.0f, 1.0f, 1.0f, 1.0f);
+static constexpr DirectX::XMFLOAT4 s_black(0.0f, 0.0f, 0.0f, 1.0f);
+static constexpr DirectX::XMFLOAT4 s_red(1.0f, 0.0f, 0.0f, 1.0f);
+static constexpr DirectX::XMFLOAT4 s_green(0.0f, 0.501960814f, 0.0f, 1.0f);
+static constexpr DirectX::XMFLOAT4 s_blue(0.0f, 0.0f, 1.0f, 1.0f);
+static constexpr DirectX::XMFLOAT4 s_yellow(1.0f, 1.0f, 0.0f, 1.0f);
+static constexpr DirectX::XMFLOAT4 s_cyan(0.0f, 1.0f, 1.0f, 1.0f);
+static constexpr DirectX::XMFLOAT4 s_magenta(1.0f, 0.0f, 1.0f, 1.0f);
+
+static constexpr std::array<Vertex, 8> s_boxVertices =
+{
+	Vertex({ DirectX::XMFLOAT3(-1.0f, -1.0f, -1.0f), s_white }),
+	Vertex({ DirectX::XMFLOAT3(-1.0f, +1.0f, -1.0f), s_black }),
+	Vertex({ DirectX::XMFLOAT3(+1.0f, +1.0f, -1.0f), s_red }),
+	Vertex({ DirectX::XMFLOAT3(+1.0f, -1.0f, -1.0f), s_green }),
+	Vertex({ DirectX::XMFLOAT3(-1.0f, -1.0f, +1.0f), s_blue }),
+	Vertex({ DirectX::XMFLOAT3(-1.0f, +1.0f, +1.0f), s_yellow }),
+	Vertex({ DirectX::XMFLOAT3(+1.0f, +1.0f, +1.0f), s_cyan }),
+	Vertex({ DirectX::XMFLOAT3(+1.0f, -1.0f, +1.0f), s_magenta })
+};
+
+static constexpr std::array<std::uint16_t, 36> s_boxIndices =
+{
+	// front face
+	0, 1, 2,
+	0, 2, 3,
+	// back face
+	4, 6, 5,
+	4, 7, 6,
+	// left face
+	4, 5, 1,
+	4, 1, 0,
+	// right face
+	3, 2, 6,
+	3, 6, 7,
+	// top face
+	1, 5, 6,
+	1, 6, 2,
+	// bottom face
+	4, 0, 3,
+	4, 3, 7
+};
+
+static constexpr std::array<Vertex, 5> s_pyramidVertices =
+{
+	// Square base of the pyramid
+	Vertex({ DirectX::XMFLOAT3(-1.0f, -1.0f, 1.0f), s_green }),
+	Vertex({ DirectX::XMFLOAT3(1.0f, -1.0f, 1.0f), s_green }),
+	Vertex({ DirectX::XMFLOAT3(-1.0f, -1.0f, -1.0f), s_green }),
+	Vertex({ DirectX::XMFLOAT3(1.0f, -1.0f, -1.0f), s_green }),
+
+	// The tip of the pyramid
+	Vertex({ DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f), s_red }),
+};
+
+static constexpr std::array<std::uint16_t, 18> s_pyramidIndices =
+{
+	0, 1, 4,
+	1, 3, 4,
+	3, 2, 4,
+	2, 0, 4,
+	0, 2, 1,
+	1, 2, 3,
+};
+
+// The box followed by the tip of a pyramid that uses the box's bottom face as its base.
+static constexpr std::array<Vertex, 9> s_boxAndPyramidVertices =
+{
+	s_boxVertices[0], s_boxVertices[1], s_boxVertices[2], s_boxVertices[3],
+	s_boxVertices[4], s_boxVertices[5], s_boxVertices[6], s_boxVertices[7],
+	Vertex({ DirectX::XMFLOAT3(+0.0f, +1.0f, +0.0f), s_red }),
+};
+
+static constexpr std::array<std::uint16_t, 54> s_boxAndPyramidIndices =
+{
+	//box indices
+	// front face
+	0, 1, 2,
+	0, 2, 3,
+	// back face
+	4, 6, 5,
+	4, 7, 6,
+	// left face
+	4, 5, 1,
+	4, 1, 0,
+	// right face
+	3, 2, 6,
+	3, 6, 7,
+	// top face
+	1, 5, 6,
+	1, 6, 2,
+	// bottom face
+	4, 0, 3,
+	4, 3, 7,
+	//pyramid indices
+	4, 7, 8,
+	7, 3, 8,
+	3, 0, 8,
+	0, 4, 8,
+	4, 0, 7,
+	7, 0, 3,
+};
+
 BoxApp::BoxApp()
 	: D3DApp()
 {
@@ -408,39 +514,9 @@ void BoxApp::BuildPrimitiveTopologyWithSingleInputSlots()
 
 void BoxApp::BuildBoxGeometryWithSingleInputSlots()
 {
-	std::array<Vertex, 8> vertices =
-	{
-		Vertex({ DirectX::XMFLOAT3(-1.0f, -1.0f, -1.0f), DirectX::XMFLOAT4(DirectX::Colors::White) }),
-		Vertex({ DirectX::XMFLOAT3(-1.0f, +1.0f, -1.0f), DirectX::XMFLOAT4(DirectX::Colors::Black) }),
-		Vertex({ DirectX::XMFLOAT3(+1.0f, +1.0f, -1.0f), DirectX::XMFLOAT4(DirectX::Colors::Red) }),
-		Vertex({ DirectX::XMFLOAT3(+1.0f, -1.0f, -1.0f), DirectX::XMFLOAT4(DirectX::Colors::Green) }),
-		Vertex({ DirectX::XMFLOAT3(-1.0f, -1.0f, +1.0f), DirectX::XMFLOAT4(DirectX::Colors::Blue) }),
-		Vertex({ DirectX::XMFLOAT3(-1.0f, +1.0f, +1.0f), DirectX::XMFLOAT4(DirectX::Colors::Yellow) }),
-		Vertex({ DirectX::XMFLOAT3(+1.0f, +1.0f, +1.0f), DirectX::XMFLOAT4(DirectX::Colors::Cyan) }),
-		Vertex({ DirectX::XMFLOAT3(+1.0f, -1.0f, +1.0f), DirectX::XMFLOAT4(DirectX::Colors::Magenta)})
-	};
+	const std::array<Vertex, 8>& vertices = s_boxVertices;
 
-	std::array<std::uint16_t, 36> indices =
-	{
-		// front face
-		0, 1, 2,
-		0, 2, 3,
-		// back face
-		4, 6, 5,
-		4, 7, 6,
-		// left face
-		4, 5, 1,
-		4, 1, 0,
-		// right face
-		3, 2, 6,
-		3, 6, 7,
-		// top face
-		1, 5, 6,
-		1, 6, 2,
-		// bottom face
-		4, 0, 3,
-		4, 3, 7
-	};
+	const std::array<std::uint16_t, 36>& indices = s_boxIndices;
 
 	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
 	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
@@ -482,27 +558,9 @@ void BoxApp::BuildBoxGeometryWithSingleInputSlots()
 
 void BoxApp::BuildPyramidGeometryWithSingleInputSlots()
 {
-	std::array<Vertex, 5> vertices =
-	{
-		// Square base of the pyramid
-		Vertex({ DirectX::XMFLOAT3(-1.0, -1.0, 1.0), DirectX::XMFLOAT4(DirectX::Colors::Green) }),
-		Vertex({ DirectX::XMFLOAT3(1.0f, -1.0, 1.0f), DirectX::XMFLOAT4(DirectX::Colors::Green) }),
-		Vertex({ DirectX::XMFLOAT3(-1.0f, -1.0f, -1.0f), DirectX::XMFLOAT4(DirectX::Colors::Green) }),
-		Vertex({ DirectX::XMFLOAT3(1.0f, -1.0, -1.0f), DirectX::XMFLOAT4(DirectX::Colors::Green) }),
-
-		// The tip of the pyramid
-		Vertex({ DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f), DirectX::XMFLOAT4(DirectX::Colors::Red) }),
-	};
+	const std::array<Vertex, 5>& vertices = s_pyramidVertices;
 
-	std::array<std::uint16_t, 18> indices =
-	{
-		0, 1, 4,
-		1, 3, 4,
-		3, 2, 4,
-		2, 0, 4,
-		0, 2, 1,
-		1, 2, 3,
-	};
+	const std::array<std::uint16_t, 18>& indices = s_pyramidIndices;
 
 	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
 	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
@@ -544,48 +602,9 @@ void BoxApp::BuildPyramidGeometryWithSingleInputSlots()
 
 void BoxApp::BuildBoxAndPyramidGeometryWithSingleInputSlots()
 {
-	std::array<Vertex, 9> vertices =
-	{
-		Vertex({ DirectX::XMFLOAT3(-1.0f, -1.0f, -1.0f), DirectX::XMFLOAT4(DirectX::Colors::White)}),
-		Vertex({ DirectX::XMFLOAT3(-1.0f, +1.0f, -1.0f), DirectX::XMFLOAT4(DirectX::Colors::Black)}),
-		Vertex({ DirectX::XMFLOAT3(+1.0f, +1.0f, -1.0f), DirectX::XMFLOAT4(DirectX::Colors::Red) }),
-		Vertex({ DirectX::XMFLOAT3(+1.0f, -1.0f, -1.0f), DirectX::XMFLOAT4(DirectX::Colors::Green)}),
-		Vertex({ DirectX::XMFLOAT3(-1.0f, -1.0f, +1.0f), DirectX::XMFLOAT4(DirectX::Colors::Blue)}),
-		Vertex({ DirectX::XMFLOAT3(-1.0f, +1.0f, +1.0f), DirectX::XMFLOAT4(DirectX::Colors::Yellow)}),
-		Vertex({ DirectX::XMFLOAT3(+1.0f, +1.0f, +1.0f), DirectX::XMFLOAT4(DirectX::Colors::Cyan)}),
-		Vertex({ DirectX::XMFLOAT3(+1.0f, -1.0f, +1.0f), DirectX::XMFLOAT4(DirectX::Colors::Magenta)}),
-		Vertex({ DirectX::XMFLOAT3(+0.0f, +1.0f, +0.0f), DirectX::XMFLOAT4(DirectX::Colors::Red)}),
-	};
+	const std::array<Vertex, 9>& vertices = s_boxAndPyramidVertices;
 
-	std::array<std::uint16_t, 54> indices =
-	{
-		//box indices
-		// front face
-		0, 1, 2,
-		0, 2, 3,
-		// back face
-		4, 6, 5,
-		4, 7, 6,
-		// left face
-		4, 5, 1,
-		4, 1, 0,
-		// right face
-		3, 2, 6,
-		3, 6, 7,
-		// top face
-		1, 5, 6,
-		1, 6, 2,
-		// bottom face
-		4, 0, 3,
-		4, 3, 7,
-		//pyramid indices
-		4, 7, 8,
-		7, 3, 8,
-		3, 0, 8,
-		0, 4, 8,
-		4, 0, 7,
-		7, 0, 3,
-	};
+	const std::array<std::uint16_t, 54>& indices = s_boxAndPyramidIndices;
 
 	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
 	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
@@ -658,27 +677,7 @@ void BoxApp::BuildBoxGeometryWithMultipleInputSlots()
 		VColorData({ DirectX::XMFLOAT4(DirectX::Colors::Magenta)})
 	};
 
-	std::array<std::uint16_t, 36> indices =
-	{
-		// front face
-		0, 1, 2,
-		0, 2, 3,
-		// back face
-		4, 6, 5,
-		4, 7, 6,
-		// left face
-		4, 5, 1,
-		4, 1, 0,
-		// right face
-		3, 2, 6,
-		3, 6, 7,
-		// top face
-		1, 5, 6,
-		1, 6, 2,
-		// bottom face
-		4, 0, 3,
-		4, 3, 7
-	};
+	const std::array<std::uint16_t, 36>& indices = s_boxIndices;
 
 	const UINT vbByteSize = (UINT)vertices.size() * sizeof(VPosData);
 	const UINT cbByteSize = (UINT)colors.size() * sizeof(VColorData);
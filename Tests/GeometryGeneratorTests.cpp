@@ -0,0 +1,784 @@
+#include "GeometryGenerator.h"
+#include "TestFramework.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory_resource>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	using Vertex = GeometryGenerator::Vertex;
+	using MeshData = GeometryGenerator::MeshData;
+
+	// The number of triangles using each undirected edge.
+	std::map<std::pair<uint32, uint32>, uint32> CountEdgeUses(const MeshData& meshData)
+	{
+		std::map<std::pair<uint32, uint32>, uint32> uses;
+		for (size_t t = 0; t + 2 < meshData.m_indices32.size(); t += 3)
+		{
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				uint32 a = meshData.m_indices32[t + k];
+				uint32 b = meshData.m_indices32[t + (k + 1) % 3];
+				++uses[std::make_pair(std::min(a, b), std::max(a, b))];
+			}
+		}
+
+		return uses;
+	}
+
+	double ElapsedMs(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//
+	// Subdivision as it was before edge midpoints were shared, the baseline for the
+	// Subdivide benchmark: every triangle emits its three corners and three midpoints.
+	//
+
+	Vertex MidPointUnshared(const Vertex& v0, const Vertex& v1)
+	{
+		DirectX::XMVECTOR pos = DirectX::XMVectorScale(
+			DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&v0.m_position), DirectX::XMLoadFloat3(&v1.m_position)), 0.5f);
+		DirectX::XMVECTOR normal = DirectX::XMVector3Normalize(DirectX::XMVectorScale(
+			DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&v0.m_normal), DirectX::XMLoadFloat3(&v1.m_normal)), 0.5f));
+		DirectX::XMVECTOR tangent = DirectX::XMVector3Normalize(DirectX::XMVectorScale(
+			DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&v0.m_tangentU), DirectX::XMLoadFloat3(&v1.m_tangentU)), 0.5f));
+		DirectX::XMVECTOR tex = DirectX::XMVectorScale(
+			DirectX::XMVectorAdd(DirectX::XMLoadFloat2(&v0.m_texC), DirectX::XMLoadFloat2(&v1.m_texC)), 0.5f);
+
+		Vertex v;
+		DirectX::XMStoreFloat3(&v.m_position, pos);
+		DirectX::XMStoreFloat3(&v.m_normal, normal);
+		DirectX::XMStoreFloat3(&v.m_tangentU, tangent);
+		DirectX::XMStoreFloat2(&v.m_texC, tex);
+
+		return v;
+	}
+
+	void SubdivideUnshared(MeshData& meshData)
+	{
+		MeshData input = meshData;
+
+		meshData.m_vertices.clear();
+		meshData.m_indices32.clear();
+
+		uint32 numTris = (uint32)input.m_indices32.size() / 3;
+		for (uint32 i = 0; i < numTris; ++i)
+		{
+			const Vertex& v0 = input.m_vertices[input.m_indices32[i * 3 + 0]];
+			const Vertex& v1 = input.m_vertices[input.m_indices32[i * 3 + 1]];
+			const Vertex& v2 = input.m_vertices[input.m_indices32[i * 3 + 2]];
+
+			meshData.m_vertices.push_back(v0);
+			meshData.m_vertices.push_back(v1);
+			meshData.m_vertices.push_back(v2);
+			meshData.m_vertices.push_back(MidPointUnshared(v0, v1));
+			meshData.m_vertices.push_back(MidPointUnshared(v1, v2));
+			meshData.m_vertices.push_back(MidPointUnshared(v0, v2));
+
+			const uint32 corners[12] = { 0, 3, 5, 3, 4, 5, 5, 4, 2, 3, 1, 4 };
+			for (uint32 corner : corners)
+				meshData.m_indices32.push_back(i * 6 + corner);
+		}
+	}
+
+	MeshData CreateBoxUnshared(uint32 numSubdivisions)
+	{
+		MeshData meshData;
+		meshData.m_vertices.assign(std::begin(GeometryTables::s_unitBoxVertices), std::end(GeometryTables::s_unitBoxVertices));
+		meshData.m_indices32.assign(std::begin(GeometryTables::s_boxIndices), std::end(GeometryTables::s_boxIndices));
+
+		for (uint32 i = 0; i < numSubdivisions; ++i)
+			SubdivideUnshared(meshData);
+
+		return meshData;
+	}
+
+	// The unit geosphere, projected and mapped as GeometryGenerator does it.
+	MeshData CreateGeosphereUnshared(uint32 numSubdivisions)
+	{
+		MeshData meshData;
+		meshData.m_vertices.resize(12);
+		meshData.m_indices32.assign(std::begin(GeometryTables::s_icosahedronIndices), std::end(GeometryTables::s_icosahedronIndices));
+
+		for (uint32 i = 0; i < 12; ++i)
+			meshData.m_vertices[i].m_position = GeometryTables::s_icosahedronPositions[i];
+
+		for (uint32 i = 0; i < numSubdivisions; ++i)
+			SubdivideUnshared(meshData);
+
+		for (Vertex& v : meshData.m_vertices)
+		{
+			DirectX::XMVECTOR n = DirectX::XMVector3Normalize(DirectX::XMLoadFloat3(&v.m_position));
+			DirectX::XMStoreFloat3(&v.m_position, n);
+			DirectX::XMStoreFloat3(&v.m_normal, n);
+
+			float theta = atan2f(v.m_position.z, v.m_position.x);
+			if (theta < 0.0f)
+				theta += DirectX::XM_2PI;
+
+			float phi = acosf(v.m_position.y);
+
+			v.m_texC = DirectX::XMFLOAT2(theta / DirectX::XM_2PI, phi / DirectX::XM_PI);
+
+			DirectX::XMVECTOR t = DirectX::XMVectorSet(-sinf(phi) * sinf(theta), 0.0f, sinf(phi) * cosf(theta), 0.0f);
+			DirectX::XMStoreFloat3(&v.m_tangentU, DirectX::XMVector3Normalize(t));
+		}
+
+		return meshData;
+	}
+
+	//
+	// The sphere and cylinder as they were generated before the shared sin/cos table:
+	// sinf and cosf per vertex, one vertex at a time.  The scalar reference for the
+	// table-driven generators.
+	//
+
+	MeshData CreateSphereScalar(float radius, uint32 sliceCount, uint32 stackCount)
+	{
+		MeshData meshData;
+
+		meshData.m_vertices.push_back(Vertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f));
+
+		float phiStep = DirectX::XM_PI / stackCount;
+		float thetaStep = 2.0f * DirectX::XM_PI / sliceCount;
+
+		for (uint32 i = 1; i <= stackCount - 1; ++i)
+		{
+			float phi = i * phiStep;
+
+			for (uint32 j = 0; j <= sliceCount; ++j)
+			{
+				float theta = j * thetaStep;
+
+				Vertex v;
+				v.m_position = DirectX::XMFLOAT3(radius * sinf(phi) * cosf(theta), radius * cosf(phi), radius * sinf(phi) * sinf(theta));
+
+				DirectX::XMVECTOR t = DirectX::XMVectorSet(-radius * sinf(phi) * sinf(theta), 0.0f, radius * sinf(phi) * cosf(theta), 0.0f);
+				DirectX::XMStoreFloat3(&v.m_tangentU, DirectX::XMVector3Normalize(t));
+				DirectX::XMStoreFloat3(&v.m_normal, DirectX::XMVector3Normalize(DirectX::XMLoadFloat3(&v.m_position)));
+
+				v.m_texC = DirectX::XMFLOAT2(theta / DirectX::XM_2PI, phi / DirectX::XM_PI);
+
+				meshData.m_vertices.push_back(v);
+			}
+		}
+
+		meshData.m_vertices.push_back(Vertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f));
+
+		for (uint32 i = 1; i <= sliceCount; ++i)
+		{
+			meshData.m_indices32.insert(meshData.m_indices32.end(), { 0, i + 1, i });
+		}
+
+		uint32 baseIndex = 1;
+		uint32 ringVertexCount = sliceCount + 1;
+		for (uint32 i = 0; i < stackCount - 2; ++i)
+		{
+			for (uint32 j = 0; j < sliceCount; ++j)
+			{
+				meshData.m_indices32.insert(meshData.m_indices32.end(), {
+					baseIndex + i * ringVertexCount + j,
+					baseIndex + i * ringVertexCount + j + 1,
+					baseIndex + (i + 1) * ringVertexCount + j,
+					baseIndex + (i + 1) * ringVertexCount + j,
+					baseIndex + i * ringVertexCount + j + 1,
+					baseIndex + (i + 1) * ringVertexCount + j + 1 });
+			}
+		}
+
+		uint32 southPoleIndex = (uint32)meshData.m_vertices.size() - 1;
+		baseIndex = southPoleIndex - ringVertexCount;
+
+		for (uint32 i = 0; i < sliceCount; ++i)
+		{
+			meshData.m_indices32.insert(meshData.m_indices32.end(), { southPoleIndex, baseIndex + i, baseIndex + i + 1 });
+		}
+
+		return meshData;
+	}
+
+	void BuildCylinderCapScalar(float radius, float height, uint32 sliceCount, bool top, MeshData& meshData)
+	{
+		uint32 baseIndex = (uint32)meshData.m_vertices.size();
+
+		float y = top ? 0.5f * height : -0.5f * height;
+		float ny = top ? 1.0f : -1.0f;
+		float dTheta = 2.0f * DirectX::XM_PI / sliceCount;
+
+		for (uint32 i = 0; i <= sliceCount; ++i)
+		{
+			float x = radius * cosf(i * dTheta);
+			float z = radius * sinf(i * dTheta);
+
+			meshData.m_vertices.push_back(Vertex(x, y, z, 0.0f, ny, 0.0f, 1.0f, 0.0f, 0.0f, x / height + 0.5f, z / height + 0.5f));
+		}
+
+		meshData.m_vertices.push_back(Vertex(0.0f, y, 0.0f, 0.0f, ny, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f));
+
+		uint32 centerIndex = (uint32)meshData.m_vertices.size() - 1;
+
+		for (uint32 i = 0; i < sliceCount; ++i)
+		{
+			if (top)
+				meshData.m_indices32.insert(meshData.m_indices32.end(), { centerIndex, baseIndex + i + 1, baseIndex + i });
+			else
+				meshData.m_indices32.insert(meshData.m_indices32.end(), { centerIndex, baseIndex + i, baseIndex + i + 1 });
+		}
+	}
+
+	MeshData CreateCylinderScalar(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount)
+	{
+		MeshData meshData;
+
+		float stackHeight = height / stackCount;
+		float radiusStep = (topRadius - bottomRadius) / stackCount;
+
+		for (uint32 i = 0; i <= stackCount; ++i)
+		{
+			float y = -0.5f * height + i * stackHeight;
+			float r = bottomRadius + i * radiusStep;
+
+			float dTheta = 2.0f * DirectX::XM_PI / sliceCount;
+			for (uint32 j = 0; j <= sliceCount; ++j)
+			{
+				float c = cosf(j * dTheta);
+				float s = sinf(j * dTheta);
+
+				Vertex v;
+				v.m_position = DirectX::XMFLOAT3(r * c, y, r * s);
+				v.m_texC = DirectX::XMFLOAT2((float)j / sliceCount, 1.0f - (float)i / stackCount);
+				v.m_tangentU = DirectX::XMFLOAT3(-s, 0.0f, c);
+
+				float dr = bottomRadius - topRadius;
+				DirectX::XMVECTOR bitangent = DirectX::XMVectorSet(dr * c, -height, dr * s, 0.0f);
+				DirectX::XMVECTOR n = DirectX::XMVector3Cross(DirectX::XMLoadFloat3(&v.m_tangentU), bitangent);
+				DirectX::XMStoreFloat3(&v.m_normal, DirectX::XMVector3Normalize(n));
+
+				meshData.m_vertices.push_back(v);
+			}
+		}
+
+		uint32 ringVertexCount = sliceCount + 1;
+		for (uint32 i = 0; i < stackCount; ++i)
+		{
+			for (uint32 j = 0; j < sliceCount; ++j)
+			{
+				meshData.m_indices32.insert(meshData.m_indices32.end(), {
+					i * ringVertexCount + j,
+					(i + 1) * ringVertexCount + j,
+					(i + 1) * ringVertexCount + j + 1,
+					i * ringVertexCount + j,
+					(i + 1) * ringVertexCount + j + 1,
+					i * ringVertexCount + j + 1 });
+			}
+		}
+
+		BuildCylinderCapScalar(topRadius, height, sliceCount, true, meshData);
+		BuildCylinderCapScalar(bottomRadius, height, sliceCount, false, meshData);
+
+		return meshData;
+	}
+
+	// Checks that two meshes have identical indices and every attribute within tolerance.
+	void CheckMeshesMatch(const MeshData& actual, const MeshData& expected, float tolerance)
+	{
+		CHECK(actual.m_indices32.size() == expected.m_indices32.size() &&
+			std::equal(actual.m_indices32.begin(), actual.m_indices32.end(), expected.m_indices32.begin()));
+
+		CHECK(actual.m_vertices.size() == expected.m_vertices.size());
+		if (actual.m_vertices.size() != expected.m_vertices.size())
+			return;
+
+		for (size_t i = 0; i < actual.m_vertices.size(); ++i)
+		{
+			const float* a = &actual.m_vertices[i].m_position.x;
+			const float* b = &expected.m_vertices[i].m_position.x;
+
+			// Position, normal, tangent and texture coordinates are 11 packed floats.
+			for (uint32 k = 0; k < sizeof(Vertex) / sizeof(float); ++k)
+				CHECK_NEAR(a[k], b[k], tolerance);
+		}
+	}
+
+	// Checks that the meshlets are packed back to back within their limits and that mapping
+	// their local triangles back through m_vertexIndices gives the mesh's index list, so
+	// every triangle is in exactly one meshlet, in index order.
+	void CheckMeshlets(const MeshData& meshData, const GeometryGenerator::MeshletData& meshlets,
+		uint32 maxVertices, uint32 maxPrimitives)
+	{
+		std::vector<uint32> indices;
+		indices.reserve(meshData.m_indices32.size());
+
+		uint32 vertexOffset = 0;
+		uint32 primitiveOffset = 0;
+
+		for (const GeometryGenerator::Meshlet& meshlet : meshlets.m_meshlets)
+		{
+			CHECK(meshlet.m_vertexOffset == vertexOffset);
+			CHECK(meshlet.m_primitiveOffset == primitiveOffset);
+			CHECK(meshlet.m_vertexCount >= 3 && meshlet.m_vertexCount <= maxVertices);
+			CHECK(meshlet.m_primitiveCount >= 1 && meshlet.m_primitiveCount <= maxPrimitives);
+
+			if (meshlet.m_vertexOffset + meshlet.m_vertexCount > meshlets.m_vertexIndices.size() ||
+				3 * (meshlet.m_primitiveOffset + meshlet.m_primitiveCount) > meshlets.m_primitiveIndices.size())
+			{
+				CHECK(!"meshlet range past the end of its arrays");
+				return;
+			}
+
+			const uint32* vertices = &meshlets.m_vertexIndices[meshlet.m_vertexOffset];
+
+			// A vertex appears once per meshlet.
+			std::vector<uint32> sorted(vertices, vertices + meshlet.m_vertexCount);
+			std::sort(sorted.begin(), sorted.end());
+			CHECK(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+
+			for (uint32 i = 0; i < 3 * meshlet.m_primitiveCount; ++i)
+			{
+				uint32 local = meshlets.m_primitiveIndices[3 * meshlet.m_primitiveOffset + i];
+				CHECK(local < meshlet.m_vertexCount);
+				indices.push_back(local < meshlet.m_vertexCount ? vertices[local] : ~0u);
+			}
+
+			// The bounding sphere holds every vertex.
+			DirectX::XMVECTOR center = DirectX::XMLoadFloat3(&meshlet.m_center);
+			for (uint32 i = 0; i < meshlet.m_vertexCount; ++i)
+			{
+				DirectX::XMVECTOR p = DirectX::XMLoadFloat3(&meshData.m_vertices[vertices[i]].m_position);
+				CHECK(DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(p, center))) <=
+					meshlet.m_radius * 1.0001f + 1e-5f);
+			}
+
+			vertexOffset += meshlet.m_vertexCount;
+			primitiveOffset += meshlet.m_primitiveCount;
+		}
+
+		CHECK(vertexOffset == meshlets.m_vertexIndices.size());
+		CHECK(3 * primitiveOffset == meshlets.m_primitiveIndices.size());
+		CHECK(indices.size() == meshData.m_indices32.size() &&
+			std::equal(indices.begin(), indices.end(), meshData.m_indices32.begin()));
+	}
+
+	// Counts in visits, one entry per quad of an mxn vertex grid, the quads of meshData, a
+	// grid or one of its tiles.  Each vertex is found in the grid from its texture coordinates
+	// and must match the row-major grid's vertex there, appear once and form quads with
+	// the row-major winding.
+	void CountGridQuads(const MeshData& meshData, const MeshData& rowMajor, uint32 m, uint32 n,
+		std::vector<uint32>& visits)
+	{
+		std::vector<uint32> gridVertex(meshData.m_vertices.size());
+		std::vector<bool> used(m * n, false);
+
+		for (size_t v = 0; v < meshData.m_vertices.size(); ++v)
+		{
+			const Vertex& vertex = meshData.m_vertices[v];
+			uint32 i = (uint32)std::lround(vertex.m_texC.y * (m - 1));
+			uint32 j = (uint32)std::lround(vertex.m_texC.x * (n - 1));
+
+			CHECK(i < m && j < n);
+			if (i >= m || j >= n)
+				return;
+
+			gridVertex[v] = i * n + j;
+
+			const Vertex& expected = rowMajor.m_vertices[i * n + j];
+			CHECK(vertex.m_position.x == expected.m_position.x && vertex.m_position.z == expected.m_position.z);
+			CHECK(!used[i * n + j]);
+			used[i * n + j] = true;
+		}
+
+		for (size_t k = 0; k + 5 < meshData.m_indices32.size(); k += 6)
+		{
+			const uint32* quad = &meshData.m_indices32[k];
+			uint32 v00 = gridVertex[quad[0]];
+			uint32 i = v00 / n;
+			uint32 j = v00 % n;
+
+			CHECK(i < m - 1 && j < n - 1);
+			if (i >= m - 1 || j >= n - 1)
+				continue;
+
+			CHECK(gridVertex[quad[1]] == v00 + 1 && gridVertex[quad[2]] == v00 + n &&
+				gridVertex[quad[3]] == v00 + n && gridVertex[quad[4]] == v00 + 1 &&
+				gridVertex[quad[5]] == v00 + n + 1);
+
+			++visits[i * (n - 1) + j];
+		}
+	}
+}
+
+//
+// Memory resources.
+//
+
+// The shapes ShapesApp::BuildShapeGeometry generates and the passes it runs on them, with
+// the generator on an arena over a fixed buffer.  Nothing may reach the arena's upstream,
+// the default resource or the global heap.
+TEST(ShapePipelineStaysInItsArena)
+{
+	const std::vector<float> lodTargets = { 0.5f, 0.25f };
+	const GeometryGenerator::TessellationTarget curvedTarget = { 0.0075f, 0.0f, 1000 };
+
+	alignas(16) static std::uint8_t buffer[8 << 20];
+
+	GeometryGenerator::AllocationCounter upstream;
+	GeometryGenerator::AllocationCounter strays;
+	std::pmr::memory_resource* previousDefault = std::pmr::set_default_resource(&strays);
+	size_t heapAllocations = TestFramework::GetHeapAllocationCount();
+
+	{
+		std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), &upstream);
+		GeometryGenerator geoGen(&arena);
+
+		MeshData box = geoGen.CreateBox(1.5f, 0.5f, 1.5f, 3);
+		MeshData grid = geoGen.CreateGrid(20.0f, 30.0f, 60, 40);
+		MeshData hilbertGrid = geoGen.CreateGrid(20.0f, 30.0f, 60, 40, GeometryGenerator::GridOrder::Hilbert);
+		CHECK(hilbertGrid.m_vertices.size() == grid.m_vertices.size());
+		MeshData sphere = geoGen.CreateSphere(0.5f, curvedTarget).m_meshData;
+		MeshData cylinder = geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, curvedTarget).m_meshData;
+
+		for (MeshData* mesh : { &box, &grid, &sphere, &cylinder })
+		{
+			geoGen.Weld(*mesh, 1e-5f, GeometryGenerator::WeldPosition);
+			geoGen.OptimizeVertexCache(*mesh);
+		}
+
+		std::pmr::vector<MeshData> sphereLods = geoGen.BuildLodChain(sphere, lodTargets);
+		std::pmr::vector<MeshData> cylinderLods = geoGen.BuildLodChain(cylinder, lodTargets);
+		CHECK(sphereLods.size() == 3 && cylinderLods.size() == 3);
+
+		geoGen.ComputeNormalsAndTangents(grid);
+
+		CHECK(upstream.GetAllocationCount() == 0);
+	}
+
+	CHECK(TestFramework::GetHeapAllocationCount() == heapAllocations);
+	CHECK(strays.GetAllocationCount() == 0);
+
+	std::pmr::set_default_resource(previousDefault);
+}
+
+//
+// 16-bit indices.
+//
+
+TEST(Indices16RejectsWideIndicesUntilPartitioned)
+{
+	GeometryGenerator geoGen;
+
+	// 301x301 vertices is more than 16-bit indices can address.
+	MeshData grid = geoGen.CreateGrid(10.0f, 10.0f, 301, 301);
+	geoGen.OptimizeVertexCache(grid);
+
+	bool threw = false;
+	try
+	{
+		grid.GetIndices16();
+	}
+	catch (const std::out_of_range&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+
+	std::vector<GeometryGenerator::IndexPartition> partitions;
+	CHECK(geoGen.PartitionIndices16(grid, partitions));
+	CHECK(partitions.size() >= 2);
+
+	// Each partition's indices are relative to its base vertex and fit in 16 bits.
+	const std::pmr::vector<uint16>& indices16 = grid.GetIndices16();
+	CHECK(indices16.size() == grid.m_indices32.size());
+
+	uint32 nextIndex = 0;
+	for (const GeometryGenerator::IndexPartition& partition : partitions)
+	{
+		CHECK(partition.m_startIndexLocation == nextIndex);
+		CHECK(partition.m_vertexCount <= 0x10000);
+		CHECK(partition.m_baseVertexLocation + partition.m_vertexCount <= grid.m_vertices.size());
+
+		for (uint32 i = 0; i < partition.m_indexCount; ++i)
+			CHECK(indices16[partition.m_startIndexLocation + i] < partition.m_vertexCount);
+
+		nextIndex += partition.m_indexCount;
+	}
+	CHECK(nextIndex == grid.m_indices32.size());
+}
+
+//
+// Subdivide (shared edge midpoints).
+//
+
+TEST(GeosphereIsClosedAndShared)
+{
+	GeometryGenerator geoGen;
+
+	for (uint32 level = 0; level <= 5; ++level)
+	{
+		MeshData geosphere = geoGen.CreateGeosphere(2.0f, level);
+
+		// An icosphere has 10 * 4^n + 2 vertices and 20 * 4^n triangles.
+		CHECK(geosphere.m_vertices.size() == 10 * (size_t(1) << (2 * level)) + 2);
+		CHECK(geosphere.m_indices32.size() == 60 * (size_t(1) << (2 * level)));
+
+		// Closed, with every edge shared by exactly two triangles.
+		for (const auto& edge : CountEdgeUses(geosphere))
+			CHECK(edge.second == 2);
+
+		// Outward facing: each triangle's normal points away from the centre.
+		for (size_t t = 0; t < geosphere.m_indices32.size(); t += 3)
+		{
+			DirectX::XMVECTOR p0 = DirectX::XMLoadFloat3(&geosphere.m_vertices[geosphere.m_indices32[t + 0]].m_position);
+			DirectX::XMVECTOR p1 = DirectX::XMLoadFloat3(&geosphere.m_vertices[geosphere.m_indices32[t + 1]].m_position);
+			DirectX::XMVECTOR p2 = DirectX::XMLoadFloat3(&geosphere.m_vertices[geosphere.m_indices32[t + 2]].m_position);
+
+			// Clockwise front faces in a left-handed frame.
+			DirectX::XMVECTOR normal = DirectX::XMVector3Cross(DirectX::XMVectorSubtract(p1, p0), DirectX::XMVectorSubtract(p2, p0));
+			CHECK(DirectX::XMVectorGetX(DirectX::XMVector3Dot(normal, p0)) > 0.0f);
+		}
+	}
+}
+
+TEST(SubdividedBoxMatchesUnshared)
+{
+	GeometryGenerator geoGen;
+
+	for (uint32 level = 0; level <= 3; ++level)
+	{
+		MeshData shared = geoGen.CreateBox(1.0f, 1.0f, 1.0f, level);
+		MeshData unshared = CreateBoxUnshared(level);
+
+		// The same triangles in the same order, only indexing shared vertices.
+		CHECK(shared.m_indices32.size() == unshared.m_indices32.size());
+		if (shared.m_indices32.size() != unshared.m_indices32.size())
+			continue;
+
+		for (size_t i = 0; i < shared.m_indices32.size(); ++i)
+		{
+			const Vertex& a = shared.m_vertices[shared.m_indices32[i]];
+			const Vertex& b = unshared.m_vertices[unshared.m_indices32[i]];
+
+			CHECK(a.m_position.x == b.m_position.x && a.m_position.y == b.m_position.y && a.m_position.z == b.m_position.z);
+			CHECK(a.m_texC.x == b.m_texC.x && a.m_texC.y == b.m_texC.y);
+		}
+	}
+}
+
+// Vertex counts and generation times of the shared midpoint Subdivide against the old
+// six-vertices-per-triangle path.  Geosphere levels are cached per process, so their
+// time is the first build of each level; run the benchmarks in a fresh process.
+BENCHMARK(SubdivideAgainstUnshared)
+{
+	GeometryGenerator geoGen;
+
+	std::printf("  %-14s %10s %10s %12s %12s\n", "mesh", "unshared", "shared", "unshared ms", "shared ms");
+
+	for (uint32 level = 3; level <= 6; ++level)
+	{
+		MeshData unshared;
+		double unsharedMs = TestFramework::TimeMs([&]() { unshared = CreateGeosphereUnshared(level); });
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		MeshData shared = geoGen.CreateGeosphere(1.0f, level);
+		double sharedMs = ElapsedMs(start);
+
+		std::printf("  geosphere %-4u %10zu %10zu %12.3f %12.3f\n", level,
+			unshared.m_vertices.size(), shared.m_vertices.size(), unsharedMs, sharedMs);
+	}
+
+	for (uint32 level = 3; level <= 6; ++level)
+	{
+		MeshData unshared;
+		double unsharedMs = TestFramework::TimeMs([&]() { unshared = CreateBoxUnshared(level); });
+
+		MeshData shared;
+		double sharedMs = TestFramework::TimeMs([&]() { shared = geoGen.CreateBox(1.0f, 1.0f, 1.0f, level); });
+
+		std::printf("  box %-10u %10zu %10zu %12.3f %12.3f\n", level,
+			unshared.m_vertices.size(), shared.m_vertices.size(), unsharedMs, sharedMs);
+	}
+}
+
+//
+// Sphere and cylinder rings from the shared sin/cos table.
+//
+
+TEST(SphereMatchesScalarReference)
+{
+	GeometryGenerator geoGen;
+
+	const uint32 sizes[][2] = { { 3, 2 }, { 4, 3 }, { 7, 5 }, { 20, 20 }, { 64, 32 }, { 255, 128 } };
+	for (const auto& size : sizes)
+		CheckMeshesMatch(geoGen.CreateSphere(1.0f, size[0], size[1]), CreateSphereScalar(1.0f, size[0], size[1]), 1e-6f);
+}
+
+TEST(CylinderMatchesScalarReference)
+{
+	GeometryGenerator geoGen;
+
+	const uint32 sizes[][2] = { { 3, 1 }, { 4, 2 }, { 7, 3 }, { 20, 20 }, { 64, 8 }, { 255, 16 } };
+	for (const auto& size : sizes)
+	{
+		CheckMeshesMatch(geoGen.CreateCylinder(0.5f, 0.3f, 1.0f, size[0], size[1]),
+			CreateCylinderScalar(0.5f, 0.3f, 1.0f, size[0], size[1]), 1e-6f);
+
+		// A straight cylinder, where the side normals have no y component.
+		CheckMeshesMatch(geoGen.CreateCylinder(0.5f, 0.5f, 1.0f, size[0], size[1]),
+			CreateCylinderScalar(0.5f, 0.5f, 1.0f, size[0], size[1]), 1e-6f);
+	}
+}
+
+//
+// Meshlets.
+//
+
+TEST(MeshletsCoverEveryTriangleOnce)
+{
+	GeometryGenerator geoGen;
+
+	MeshData grid = geoGen.CreateGrid(10.0f, 10.0f, 41, 41);
+	MeshData optimizedGrid = grid;
+	geoGen.OptimizeVertexCache(optimizedGrid);
+
+	const MeshData meshes[] = {
+		geoGen.CreateGeosphere(1.0f, 3),
+		geoGen.CreateSphere(1.0f, 30, 20),
+		geoGen.CreateCylinder(0.5f, 0.3f, 1.0f, 20, 4),
+		geoGen.CreateBox(1.0f, 1.0f, 1.0f, 2),
+		grid,
+		optimizedGrid,
+	};
+
+	// The defaults, the smallest meshlets, a vertex limit that binds before the primitive
+	// limit and the largest vertex count a byte of local index allows.
+	const uint32 limits[][2] = { { 64, 124 }, { 3, 1 }, { 3, 8 }, { 16, 124 }, { 128, 32 }, { 256, 512 } };
+
+	for (const MeshData& mesh : meshes)
+	{
+		for (const auto& limit : limits)
+			CheckMeshlets(mesh, geoGen.BuildMeshlets(mesh, limit[0], limit[1]), limit[0], limit[1]);
+	}
+}
+
+TEST(MeshletsFillToTheirLimits)
+{
+	GeometryGenerator geoGen;
+
+	// Any second triangle brings at least a fourth vertex, so a three vertex limit gives
+	// one triangle per meshlet.
+	MeshData sphere = geoGen.CreateSphere(1.0f, 30, 20);
+	GeometryGenerator::MeshletData single = geoGen.BuildMeshlets(sphere, 3, 124);
+	CHECK(single.m_meshlets.size() == sphere.m_indices32.size() / 3);
+
+	// A one quad wide strip adds a vertex per triangle, so with room for 256 vertices every
+	// meshlet but the last stops at the primitive limit.
+	MeshData grid = geoGen.CreateGrid(10.0f, 10.0f, 2, 201);
+	GeometryGenerator::MeshletData strips = geoGen.BuildMeshlets(grid, 256, 32);
+	for (size_t i = 0; i + 1 < strips.m_meshlets.size(); ++i)
+		CHECK(strips.m_meshlets[i].m_primitiveCount == 32);
+}
+
+//
+// Grid quad orders.
+//
+
+TEST(GridOrdersVisitEveryQuadOnce)
+{
+	GeometryGenerator geoGen;
+
+	const GeometryGenerator::GridOrder orders[] = {
+		GeometryGenerator::GridOrder::RowMajor, GeometryGenerator::GridOrder::Morton, GeometryGenerator::GridOrder::Hilbert };
+
+	// Every grid from 1x1 to 70x70 quads, so the curves are clipped at every offset within
+	// their enclosing power of two.
+	for (uint32 rows = 1; rows <= 70; ++rows)
+	{
+		for (uint32 cols = 1; cols <= 70; ++cols)
+		{
+			uint32 m = rows + 1;
+			uint32 n = cols + 1;
+			MeshData rowMajor = geoGen.CreateGrid(10.0f, 10.0f, m, n);
+
+			for (GeometryGenerator::GridOrder order : orders)
+			{
+				MeshData grid = geoGen.CreateGrid(10.0f, 10.0f, m, n, order);
+				CHECK(grid.m_vertices.size() == m * n);
+				CHECK(grid.m_indices32.size() == rows * cols * 6);
+
+				std::vector<uint32> visits(rows * cols, 0);
+				CountGridQuads(grid, rowMajor, m, n, visits);
+				CHECK(std::count(visits.begin(), visits.end(), 1u) == (std::ptrdiff_t)visits.size());
+			}
+		}
+	}
+}
+
+TEST(GridTileOrdersVisitEveryQuadOnce)
+{
+	GeometryGenerator geoGen;
+
+	const GeometryGenerator::GridOrder orders[] = {
+		GeometryGenerator::GridOrder::RowMajor, GeometryGenerator::GridOrder::Morton, GeometryGenerator::GridOrder::Hilbert };
+	const uint32 sizes[] = { 1, 2, 3, 7, 16, 17, 33, 70 };
+	const uint32 tileSizes[] = { 1, 5, 16 };
+
+	for (uint32 rows : sizes)
+	{
+		for (uint32 cols : sizes)
+		{
+			uint32 m = rows + 1;
+			uint32 n = cols + 1;
+			MeshData rowMajor = geoGen.CreateGrid(10.0f, 10.0f, m, n);
+
+			for (uint32 tileQuads : tileSizes)
+			{
+				for (GeometryGenerator::GridOrder order : orders)
+				{
+					// The tiles between them cover the grid, each quad in exactly one tile.
+					std::vector<uint32> visits(rows * cols, 0);
+					for (const MeshData& tile : geoGen.CreateGridTiles(10.0f, 10.0f, m, n, tileQuads, order))
+						CountGridQuads(tile, rowMajor, m, n, visits);
+
+					CHECK(std::count(visits.begin(), visits.end(), 1u) == (std::ptrdiff_t)visits.size());
+				}
+			}
+		}
+	}
+}
+
+// Post-transform cache efficiency and generation time of each grid order.  ACMR is
+// vertices transformed per triangle and ATVR per vertex; 0.5 and 1.0 are the ideal.
+BENCHMARK(GridOrderVertexCache)
+{
+	GeometryGenerator geoGen;
+
+	const std::pair<GeometryGenerator::GridOrder, const char*> orders[] = {
+		{ GeometryGenerator::GridOrder::RowMajor, "row-major" },
+		{ GeometryGenerator::GridOrder::Morton, "Morton" },
+		{ GeometryGenerator::GridOrder::Hilbert, "Hilbert" } };
+	const uint32 sizes[][2] = { { 1025, 1025 }, { 4097, 65 } };
+
+	std::printf("  %-20s %9s %9s %9s %9s %9s\n", "grid", "ACMR 16", "ATVR 16", "ACMR 32", "ATVR 32", "ms");
+
+	for (const auto& size : sizes)
+	{
+		for (const auto& order : orders)
+		{
+			MeshData grid;
+			double ms = TestFramework::TimeMs([&]() { grid = geoGen.CreateGrid(10.0f, 10.0f, size[0], size[1], order.first); });
+
+			GeometryGenerator::VertexCacheStats stats16 = geoGen.AnalyzeVertexCache(grid, 16);
+			GeometryGenerator::VertexCacheStats stats32 = geoGen.AnalyzeVertexCache(grid, 32);
+
+			std::printf("  %4ux%-4u %-10s %9.3f %9.3f %9.3f %9.3f %9.3f\n", size[0], size[1], order.second,
+				stats16.m_acmr, stats16.m_atvr, stats32.m_acmr, stats32.m_atvr, ms);
+		}
+	}
+}
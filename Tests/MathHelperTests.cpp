@@ -0,0 +1,302 @@
+#include "MathHelper.h"
+#include "TestFramework.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// Checks every element of actual against expected within tolerance times the largest
+	// element of expected, so matrices with large translations or projection terms are
+	// held to the same relative precision as unit rotations.
+	void CheckMatrixNear(CXMMATRIX actual, CXMMATRIX expected, float tolerance)
+	{
+		XMFLOAT4X4 a;
+		XMFLOAT4X4 e;
+		XMStoreFloat4x4(&a, actual);
+		XMStoreFloat4x4(&e, expected);
+
+		float scale = 1.0f;
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+				scale = std::max(scale, std::fabs(e.m[i][j]));
+		}
+
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+				CHECK_NEAR(a.m[i][j], e.m[i][j], tolerance * scale);
+		}
+	}
+
+	XMMATRIX InverseReference(CXMMATRIX M)
+	{
+		XMVECTOR determinant;
+		return XMMatrixInverse(&determinant, M);
+	}
+
+	XMMATRIX RandomRotation(RandomGenerator& random)
+	{
+		return XMMatrixRotationRollPitchYaw(random.NextFloat(-XM_PI, XM_PI), random.NextFloat(-XM_PI, XM_PI),
+			random.NextFloat(-XM_PI, XM_PI));
+	}
+
+	XMMATRIX RandomTranslation(RandomGenerator& random)
+	{
+		return XMMatrixTranslation(random.NextFloat(-100.0f, 100.0f), random.NextFloat(-100.0f, 100.0f),
+			random.NextFloat(-100.0f, 100.0f));
+	}
+
+	// Scale, then shear, then rotation, then translation.  The shear is unit upper
+	// triangular, so the determinant is the product of the scales.
+	XMMATRIX RandomAffine(RandomGenerator& random)
+	{
+		XMMATRIX scale = XMMatrixScaling(random.NextFloat(0.1f, 10.0f), random.NextFloat(0.1f, 10.0f),
+			random.NextFloat(0.1f, 10.0f));
+
+		XMMATRIX shear(
+			1.0f, random.NextFloat(-1.0f, 1.0f), random.NextFloat(-1.0f, 1.0f), 0.0f,
+			0.0f, 1.0f, random.NextFloat(-1.0f, 1.0f), 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+
+		return XMMatrixMultiply(XMMatrixMultiply(XMMatrixMultiply(scale, shear), RandomRotation(random)),
+			RandomTranslation(random));
+	}
+
+	const int s_randomCases = 1000;
+
+	// XMMatrixInverse rounds in float too, and the scales of up to 100:1 and the shear in
+	// RandomAffine make its error grow with the condition number.
+	const float s_rigidTolerance = 1e-5f;
+	const float s_affineTolerance = 1e-4f;
+	const float s_perspectiveTolerance = 1e-5f;
+
+	//
+	// The per-object constant buffer update as UpdateObjectCBs did it before
+	// StoreTransposedMatrices: load, transpose, store into an ObjectConstants on the stack
+	// and copy that into the slot.
+	//
+
+	struct ObjectConstants
+	{
+		XMFLOAT4X4 World;
+	};
+
+	void StoreTransposedPerItem(std::uint8_t* dest, size_t destStride, const XMFLOAT4X4* src,
+		const std::uint32_t* indices, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			XMMATRIX world = XMLoadFloat4x4(&src[indices[i]]);
+
+			ObjectConstants objectConstants;
+			XMStoreFloat4x4(&objectConstants.World, XMMatrixTranspose(world));
+
+			std::memcpy(dest + indices[i] * destStride, &objectConstants, sizeof(objectConstants));
+		}
+	}
+
+	// A 16 byte aligned block of a mapped buffer stand-in, as upload heap mappings are.
+	struct alignas(16) Block
+	{
+		std::uint8_t m_bytes[16];
+	};
+
+	// Indices 0 to count - 1 when fraction is one, otherwise about that fraction of them
+	// chosen at random, in increasing order as an update over the render items finds them.
+	std::vector<std::uint32_t> DirtyIndices(RandomGenerator& random, std::uint32_t count, float fraction)
+	{
+		std::vector<std::uint32_t> indices;
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			if (fraction >= 1.0f || random.NextFloat() < fraction)
+				indices.push_back(i);
+		}
+
+		return indices;
+	}
+
+	std::vector<XMFLOAT4X4> RandomMatrices(RandomGenerator& random, size_t count)
+	{
+		std::vector<XMFLOAT4X4> matrices(count);
+		random.FillFloats(&matrices[0]._11, count * 16, -10.0f, 10.0f);
+
+		return matrices;
+	}
+}
+
+//
+// Closed form inverses against XMMatrixInverse.
+//
+
+TEST(InverseRigidMatchesInverse)
+{
+	RandomGenerator random(1);
+
+	for (int i = 0; i < s_randomCases; ++i)
+	{
+		XMMATRIX M = XMMatrixMultiply(RandomRotation(random), RandomTranslation(random));
+		CheckMatrixNear(MathHelper::InverseRigid(M), InverseReference(M), s_rigidTolerance);
+	}
+}
+
+TEST(InverseAffineMatchesInverse)
+{
+	RandomGenerator random(2);
+
+	for (int i = 0; i < s_randomCases; ++i)
+	{
+		XMMATRIX M = RandomAffine(random);
+		CheckMatrixNear(MathHelper::InverseAffine(M), InverseReference(M), s_affineTolerance);
+	}
+}
+
+TEST(InverseTransposeAffineMatchesInverse)
+{
+	RandomGenerator random(3);
+
+	for (int i = 0; i < s_randomCases; ++i)
+	{
+		XMMATRIX M = RandomAffine(random);
+
+		// Only the 3x3 is inverted; the translation never reaches a normal.
+		XMMATRIX linear = M;
+		linear.r[3] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+
+		CheckMatrixNear(MathHelper::InverseTransposeAffine(M), XMMatrixTranspose(InverseReference(linear)),
+			s_affineTolerance);
+		CheckMatrixNear(MathHelper::InverseTranspose(M), MathHelper::InverseTransposeAffine(M), 0.0f);
+	}
+}
+
+TEST(InversePerspectiveMatchesInverse)
+{
+	RandomGenerator random(4);
+
+	for (int i = 0; i < s_randomCases; ++i)
+	{
+		float fovY = random.NextFloat(0.1f * XM_PI, 0.8f * XM_PI);
+		float aspect = random.NextFloat(0.5f, 3.0f);
+		float nearZ = random.NextFloat(0.01f, 1.0f);
+		float farZ = random.NextFloat(10.0f, 1000.0f);
+
+		XMMATRIX lh = XMMatrixPerspectiveFovLH(fovY, aspect, nearZ, farZ);
+		XMMATRIX rh = XMMatrixPerspectiveFovRH(fovY, aspect, nearZ, farZ);
+
+		CheckMatrixNear(MathHelper::InversePerspective(lh), InverseReference(lh), s_perspectiveTolerance);
+		CheckMatrixNear(MathHelper::InversePerspective(rh), InverseReference(rh), s_perspectiveTolerance);
+
+		// Off centre, as for a jittered or tiled frustum or one eye of a stereo pair.
+		float left = random.NextFloat(-2.0f, 1.0f) * nearZ;
+		float right = left + random.NextFloat(0.1f, 2.0f) * nearZ;
+		float bottom = random.NextFloat(-2.0f, 1.0f) * nearZ;
+		float top = bottom + random.NextFloat(0.1f, 2.0f) * nearZ;
+
+		XMMATRIX offCenterLH = XMMatrixPerspectiveOffCenterLH(left, right, bottom, top, nearZ, farZ);
+		XMMATRIX offCenterRH = XMMatrixPerspectiveOffCenterRH(left, right, bottom, top, nearZ, farZ);
+
+		CheckMatrixNear(MathHelper::InversePerspective(offCenterLH), InverseReference(offCenterLH), s_perspectiveTolerance);
+		CheckMatrixNear(MathHelper::InversePerspective(offCenterRH), InverseReference(offCenterRH), s_perspectiveTolerance);
+	}
+}
+
+//
+// Per-object constant buffer updates.
+//
+
+TEST(StoreTransposedMatricesMatchesPerItem)
+{
+	RandomGenerator random(5);
+
+	const std::uint32_t count = 1000;
+	std::vector<XMFLOAT4X4> matrices = RandomMatrices(random, count);
+
+	// Constant buffer slots, a packed 16 byte multiple and a stride streaming can't use.
+	const size_t strides[] = { 256, 64, 68 };
+	const float fractions[] = { 1.0f, 0.1f };
+	const TransformStore stores[] = { TransformStore::Cached, TransformStore::Streaming };
+
+	for (size_t stride : strides)
+	{
+		for (float fraction : fractions)
+		{
+			std::vector<std::uint32_t> indices = DirtyIndices(random, count, fraction);
+
+			std::vector<Block> expected(count * stride / sizeof(Block) + 1);
+			std::memset(expected.data(), 0xcd, expected.size() * sizeof(Block));
+			StoreTransposedPerItem(expected[0].m_bytes, stride, matrices.data(), indices.data(), indices.size());
+
+			for (TransformStore store : stores)
+			{
+				// Slots that are not dirty must be left alone, so both start from the same fill.
+				std::vector<Block> actual(expected.size());
+				std::memset(actual.data(), 0xcd, actual.size() * sizeof(Block));
+
+				// A null index list stands for every matrix.
+				MathHelper::StoreTransposedMatrices(actual[0].m_bytes, stride, matrices.data(),
+					fraction >= 1.0f ? nullptr : indices.data(), indices.size(), store);
+
+				CHECK(std::memcmp(actual.data(), expected.data(), actual.size() * sizeof(Block)) == 0);
+			}
+		}
+	}
+}
+
+// Nanoseconds per dirty object of the per-item update against StoreTransposedMatrices
+// with streaming and cached stores, into 256 byte constant buffer slots.  The buffers here
+// are ordinary memory; a real upload heap is write-combined, which favours streaming.
+BENCHMARK(StoreTransposedMatricesAgainstPerItem)
+{
+	RandomGenerator random(6);
+
+	const std::uint32_t counts[] = { 10000, 100000, 1000000 };
+	const float fractions[] = { 1.0f, 0.1f };
+	const size_t slotSize = 256;
+
+	std::printf("  %8s %6s %12s %12s %12s\n", "objects", "dirty", "per-item", "streaming", "cached");
+
+	for (std::uint32_t count : counts)
+	{
+		std::vector<XMFLOAT4X4> matrices = RandomMatrices(random, count);
+		std::vector<Block> expected(count * slotSize / sizeof(Block));
+		std::vector<Block> actual(expected.size());
+
+		for (float fraction : fractions)
+		{
+			std::vector<std::uint32_t> indices = DirtyIndices(random, count, fraction);
+			double perDirty = 1e6 / indices.size();
+
+			std::memset(expected.data(), 0, expected.size() * sizeof(Block));
+			double perItemMs = TestFramework::TimeMs([&]()
+			{
+				StoreTransposedPerItem(expected[0].m_bytes, slotSize, matrices.data(), indices.data(), indices.size());
+			});
+
+			auto timeBatch = [&](TransformStore store)
+			{
+				std::memset(actual.data(), 0, actual.size() * sizeof(Block));
+				double ms = TestFramework::TimeMs([&]()
+				{
+					MathHelper::StoreTransposedMatrices(actual[0].m_bytes, slotSize, matrices.data(), indices.data(),
+						indices.size(), store);
+				});
+
+				CHECK(std::memcmp(actual.data(), expected.data(), actual.size() * sizeof(Block)) == 0);
+				return ms;
+			};
+
+			double streamingMs = timeBatch(TransformStore::Streaming);
+			double cachedMs = timeBatch(TransformStore::Cached);
+
+			std::printf("  %8u %5.0f%% %12.1f %12.1f %12.1f\n", count, fraction * 100.0f,
+				perItemMs * perDirty, streamingMs * perDirty, cachedMs * perDirty);
+		}
+	}
+}
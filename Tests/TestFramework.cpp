@@ -0,0 +1,128 @@
+#include "TestFramework.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace
+{
+	struct RegisteredTest
+	{
+		const char* m_name;
+		TestFramework::TestFunction m_function;
+		bool m_benchmark;
+	};
+
+	// A function local static, so registrations from other files' static initialisers
+	// never see it unconstructed.
+	std::vector<RegisteredTest>& GetRegisteredTests()
+	{
+		static std::vector<RegisteredTest> tests;
+		return tests;
+	}
+
+	// Failures in the running test.  Only the first few are printed, since a broken
+	// check inside a loop would otherwise bury the rest of the output.
+	const int s_maxPrintedFailures = 10;
+	int s_failures = 0;
+
+	bool BeginFailure()
+	{
+		return ++s_failures <= s_maxPrintedFailures;
+	}
+
+	std::atomic<size_t> s_heapAllocations{ 0 };
+}
+
+// The array and nothrow forms call these, so every plain heap allocation is counted.
+void* operator new(size_t size)
+{
+	++s_heapAllocations;
+
+	if (void* p = std::malloc(size != 0 ? size : 1))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+size_t TestFramework::GetHeapAllocationCount()
+{
+	return s_heapAllocations.load();
+}
+
+TestFramework::Registration::Registration(const char* name, TestFunction function, bool benchmark)
+{
+	GetRegisteredTests().push_back({ name, function, benchmark });
+}
+
+void TestFramework::Fail(const char* file, int line, const char* expression)
+{
+	if (BeginFailure())
+		std::printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+}
+
+void TestFramework::FailNear(const char* file, int line, const char* expression, double actual, double expected,
+	double tolerance)
+{
+	if (BeginFailure())
+	{
+		std::printf("  %s(%d): %s is %.9g, expected %.9g within %.3g\n",
+			file, line, expression, actual, expected, tolerance);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool benchmarks = false;
+	const char* filter = nullptr;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--bench") == 0)
+			benchmarks = true;
+		else
+			filter = argv[i];
+	}
+
+	int run = 0;
+	int failed = 0;
+
+	for (const RegisteredTest& test : GetRegisteredTests())
+	{
+		if (test.m_benchmark != benchmarks || (filter && !std::strstr(test.m_name, filter)))
+			continue;
+
+		std::printf("[ RUN    ] %s\n", test.m_name);
+		std::fflush(stdout);
+
+		s_failures = 0;
+		test.m_function();
+		++run;
+
+		if (s_failures > 0)
+		{
+			++failed;
+			std::printf("[ FAILED ] %s (%d failed checks)\n", test.m_name, s_failures);
+		}
+		else
+		{
+			std::printf("[     OK ] %s\n", test.m_name);
+		}
+	}
+
+	std::printf("%d of %d %s passed\n", run - failed, run, benchmarks ? "benchmarks" : "tests");
+
+	return failed;
+}
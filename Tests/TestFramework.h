@@ -0,0 +1,77 @@
+//***************************************************************************************
+// TestFramework.h
+//
+// A small test and benchmark runner for the Common code.  TEST and BENCHMARK register a
+// function when the program starts; CHECK and CHECK_NEAR record a failure and let the
+// test carry on.  Tests.exe runs every test and returns the number that failed, and
+// Tests.exe --bench runs the benchmarks instead.  Either takes a name filter after it.
+//***************************************************************************************
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+
+namespace TestFramework
+{
+	using TestFunction = void (*)();
+
+	struct Registration
+	{
+		Registration(const char* name, TestFunction function, bool benchmark);
+	};
+
+	// The number of allocations made through the global operator new so far, which the
+	// test program replaces.  Take the difference around code that should keep to the
+	// memory resource it is given.
+	size_t GetHeapAllocationCount();
+
+	void Fail(const char* file, int line, const char* expression);
+	void FailNear(const char* file, int line, const char* expression, double actual, double expected, double tolerance);
+
+	inline void CheckNear(const char* file, int line, const char* expression, double actual, double expected,
+		double tolerance)
+	{
+		if (!(std::fabs(actual - expected) <= tolerance))
+			FailNear(file, line, expression, actual, expected, tolerance);
+	}
+
+	// Calls function once to warm up, then until at least minSeconds have passed, and
+	// returns the mean time of one call in milliseconds.
+	template<typename Function>
+	double TimeMs(Function&& function, double minSeconds = 0.2)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		function();
+
+		int calls = 0;
+		Clock::time_point start = Clock::now();
+		Clock::duration elapsed;
+		do
+		{
+			function();
+			++calls;
+			elapsed = Clock::now() - start;
+		} while (elapsed < std::chrono::duration<double>(minSeconds));
+
+		return std::chrono::duration<double, std::milli>(elapsed).count() / calls;
+	}
+}
+
+#define TEST(name) \
+	static void name(); \
+	static TestFramework::Registration name##Registration(#name, name, false); \
+	static void name()
+
+#define BENCHMARK(name) \
+	static void name(); \
+	static TestFramework::Registration name##Registration(#name, name, true); \
+	static void name()
+
+#define CHECK(expression) \
+	((expression) ? (void)0 : TestFramework::Fail(__FILE__, __LINE__, #expression))
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+	TestFramework::CheckNear(__FILE__, __LINE__, #actual, (actual), (expected), (tolerance))